@@ -0,0 +1,246 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ResourceArchive.hpp"
+
+//
+// Background asset loader. Files are queued up front, then decoded in
+// parallel on worker threads into plain memory (sf::Image pixels, sound
+// samples). Everything that needs the GL or audio context stays on the main
+// thread: update() is called once per frame and spends at most its time
+// budget turning decoded data into sf::Texture / sf::SoundBuffer, uploading
+// big textures a band of rows at a time so a frame never stalls on one file.
+// Files found in a ResourceArchive are taken from its already decoded data
+// and skip the file system and the decoders altogether.
+//
+class AssetLoader {
+public:
+    explicit AssetLoader(const ResourceArchive *archive = nullptr) : m_archive(archive) {}
+    AssetLoader(const AssetLoader &) = delete;
+    AssetLoader &operator=(const AssetLoader &) = delete;
+
+    ~AssetLoader() {
+        m_stop = true;
+        for (std::thread &t : m_workers)
+            t.join();
+    }
+
+    // Decodes into an sf::Image only (e.g. for the texture atlas).
+    void image(const std::string &path, sf::Image &out) {
+        Job &job = push(path, true, nullptr);
+        job.image = &out;
+    }
+
+    //
+    // Decodes an image and uploads it into `out`. Texture flags set before
+    // (setRepeated, setSmooth) are kept. onReady runs on the main thread once
+    // the texture is complete; optional files that fail are only reported.
+    //
+    void texture(const std::string &path, sf::Texture &out, bool required = true,
+                 std::function<void()> onReady = nullptr) {
+        Job &job = push(path, required, std::move(onReady));
+        job.texture = &out;
+    }
+
+    void sound(const std::string &path, sf::SoundBuffer &out) {
+        Job &job = push(path, true, nullptr);
+        job.sound = &out;
+    }
+
+    // Starts decoding everything queued so far. Nothing may be queued after this.
+    void start(unsigned threads = std::thread::hardware_concurrency()) {
+        threads = std::max(1u, std::min(threads, static_cast<unsigned>(m_jobs.size())));
+        for (unsigned t = 0; t < threads; ++t)
+            m_workers.emplace_back([this] { work(); });
+    }
+
+    //
+    // Main thread, once per frame: finishes decoded assets until `budget`
+    // seconds are spent. Returns true once every asset is ready.
+    //
+    bool update(float budget) {
+        sf::Clock clock;
+        for (auto &jp : m_jobs) {
+            Job &job = *jp;
+            if (job.finished)
+                continue;
+            int state = job.state.load(std::memory_order_acquire);
+            if (state == PENDING)
+                continue;
+            if (state == FAILED) {
+                std::cerr << "Failed to load " << job.path << "\n";
+                if (job.required)
+                    m_failed = true;
+                finish(job);
+                continue;
+            }
+            while (!job.finished && clock.getElapsedTime().asSeconds() < budget)
+                finishSlice(job);
+            if (clock.getElapsedTime().asSeconds() >= budget)
+                break;
+        }
+        return done();
+    }
+
+    bool done() const { return m_finished == m_jobs.size(); }
+
+    // A required file could not be loaded.
+    bool failed() const { return m_failed; }
+
+    // 0..1: decoding and uploading count half each.
+    float progress() const {
+        if (m_jobs.empty())
+            return 1.f;
+        return static_cast<float>(m_decoded.load() + m_finished) / (2.f * m_jobs.size());
+    }
+
+private:
+    enum { PENDING, DECODED, FAILED };
+
+    // Texture uploads are split into bands of about this many bytes.
+    static constexpr unsigned SLICE_BYTES = 256 * 1024;
+
+    struct Job {
+        std::string path;
+        bool required = true;
+        std::function<void()> onReady;
+        sf::Image *image = nullptr;
+        sf::Texture *texture = nullptr;
+        sf::SoundBuffer *sound = nullptr;
+        std::atomic<int> state{ PENDING };
+        bool finished = false;
+
+        // Decoded data waiting for the main thread; the pointers either point
+        // into the vectors below or straight into the archive.
+        sf::Image pixels;
+        const sf::Uint8 *pixelData = nullptr;
+        unsigned width = 0, height = 0, uploadedRows = 0;
+        std::vector<sf::Int16> samples;
+        const sf::Int16 *sampleData = nullptr;
+        std::uint64_t sampleCount = 0;
+        unsigned channels = 0, sampleRate = 0;
+    };
+
+    Job &push(const std::string &path, bool required, std::function<void()> onReady) {
+        m_jobs.push_back(std::unique_ptr<Job>(new Job()));
+        Job &job = *m_jobs.back();
+        job.path = path;
+        job.required = required;
+        job.onReady = std::move(onReady);
+        return job;
+    }
+
+    // Worker thread: takes the next queued file and decodes it.
+    void work() {
+        for (;;) {
+            size_t i = m_next++;
+            if (m_stop || i >= m_jobs.size())
+                return;
+            Job &job = *m_jobs[i];
+            bool ok = decode(job);
+            ++m_decoded;
+            job.state.store(ok ? DECODED : FAILED, std::memory_order_release);
+        }
+    }
+
+    bool decode(Job &job) const {
+        ResourceArchive::Resource res;
+        if (m_archive)
+            res = m_archive->find(job.path);
+        if (job.sound) {
+            if (res && res.entry->kind == ArchiveEntry::SOUND) {
+                job.sampleData = res.samples();
+                job.sampleCount = res.sampleCount();
+                job.channels = res.channels();
+                job.sampleRate = res.sampleRate();
+                return true;
+            }
+            sf::InputSoundFile file;
+            if (!file.openFromFile(job.path))
+                return false;
+            job.samples.resize(static_cast<size_t>(file.getSampleCount()));
+            job.channels = file.getChannelCount();
+            job.sampleRate = file.getSampleRate();
+            job.sampleData = job.samples.data();
+            job.sampleCount = job.samples.size();
+            return file.read(job.samples.data(), job.samples.size()) == job.samples.size();
+        }
+        if (res && res.entry->kind == ArchiveEntry::IMAGE) {
+            if (job.image) {
+                job.image->create(res.width(), res.height(), res.pixels());
+            } else {
+                job.pixelData = res.pixels();
+                job.width = res.width();
+                job.height = res.height();
+            }
+            return true;
+        }
+        if (job.image)
+            return job.image->loadFromFile(job.path);
+        if (!job.pixels.loadFromFile(job.path))
+            return false;
+        job.pixelData = job.pixels.getPixelsPtr();
+        job.width = job.pixels.getSize().x;
+        job.height = job.pixels.getSize().y;
+        return true;
+    }
+
+    // Main thread: does the next bounded piece of work for a decoded job.
+    void finishSlice(Job &job) {
+        if (job.image) {
+            finish(job);
+        } else if (job.texture) {
+            sf::Vector2u s(job.width, job.height);
+            if (job.uploadedRows == 0 && !job.texture->create(s.x, s.y)) {
+                std::cerr << "Failed to create texture for " << job.path << "\n";
+                m_failed = m_failed || job.required;
+                job.state = FAILED;
+                finish(job);
+                return;
+            }
+            unsigned rows = std::max(1u, SLICE_BYTES / (4 * std::max(1u, s.x)));
+            rows = std::min(rows, s.y - job.uploadedRows);
+            job.texture->update(job.pixelData + 4 * s.x * job.uploadedRows,
+                                s.x, rows, 0, job.uploadedRows);
+            job.uploadedRows += rows;
+            if (job.uploadedRows >= s.y) {
+                job.pixels = sf::Image();
+                finish(job);
+            }
+        } else {
+            if (!job.sound->loadFromSamples(job.sampleData, job.sampleCount, job.channels, job.sampleRate)) {
+                std::cerr << "Failed to load " << job.path << "\n";
+                m_failed = true;
+            }
+            job.samples.clear();
+            job.samples.shrink_to_fit();
+            finish(job);
+        }
+    }
+
+    void finish(Job &job) {
+        job.finished = true;
+        ++m_finished;
+        if (job.onReady && job.state == DECODED)
+            job.onReady();
+    }
+
+    const ResourceArchive *m_archive;
+    std::vector<std::unique_ptr<Job>> m_jobs;
+    std::vector<std::thread> m_workers;
+    std::atomic<size_t> m_next{ 0 };
+    std::atomic<unsigned> m_decoded{ 0 };
+    std::atomic<bool> m_stop{ false };
+    size_t m_finished = 0;
+    bool m_failed = false;
+};
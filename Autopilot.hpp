@@ -0,0 +1,385 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include "Profiler.hpp"
+#include "RaceSimulation.hpp"
+
+//
+// What the autopilot's model knows about the road for one plan: the
+// obstacles and collectibles on screen or coming in within the plan's
+// horizon, and the geometry they need, in world space like the simulation.
+// Filled once per plan from the RaceSimulation and shared read-only by
+// every branch.
+//
+struct PlanTrack {
+    static const int MAX_OBSTACLES = 64;  // one bit each in PlanState
+    static const int MAX_PICKUPS = 32;
+
+    RaceConfig cfg;
+    float laneX[LaneIndex<RaceSimulation::MAX_OBSTACLES>::MAX_LANES];  // player x in each lane
+    float playerY = 0.f, playerW = 0.f, playerH = 0.f;  // playerY in the view
+
+    // Obstacles on the road first, then the ones still to come in track order.
+    int obstacleCount = 0;
+    float obstacleX[MAX_OBSTACLES], obstacleW[MAX_OBSTACLES], obstacleH[MAX_OBSTACLES];
+    float obstacleAt[MAX_OBSTACLES];  // track position it comes in at (pending ones)
+
+    // Bottles and coins, on the road or to come; they don't move.
+    int pickupCount = 0;
+    float pickupX[MAX_PICKUPS], pickupY[MAX_PICKUPS], pickupW[MAX_PICKUPS], pickupH[MAX_PICKUPS];
+    float pickupAt[MAX_PICKUPS];
+    bool pickupIsCoin[MAX_PICKUPS];
+};
+
+//
+// One branch of the autopilot's search: the race as far as the model is
+// concerned, a flat value type of a few hundred bytes, so every branch is a
+// plain copy. What moves lives here, everything that does not change along
+// a branch lives in PlanTrack. The speed and stamina fields have the names
+// RaceSimulation::updateSpeed expects.
+//
+struct PlanState {
+    GameState state = GAME;
+    int playerLane = 0, lives = 0, score = 0;
+    float stamina = 0.f, playerWorldSpeed = 0.f, distanceTraveled = 0.f, hitTime = 0.f;
+    bool boosting = false, braking = false, triedWhileExhausted = false, raceFinished = false;
+    float trackPos = 0.f;
+    float lastRowAt = -1.f;      // same gating of obstacle rows as the simulation
+    int obstaclesReleased = 0;   // obstacles [0, obstaclesReleased) have come in
+    int newestObstacle = -1;
+    std::uint64_t obstacleLive = 0;  // bit i: obstacle i is on the road
+    std::uint32_t pickupReleased = 0, pickupLive = 0;
+    float obstacleY[PlanTrack::MAX_OBSTACLES];
+
+    // Search bookkeeping.
+    float value = 0.f;
+    RaceInput first;  // the action this branch started with
+};
+
+static_assert(std::is_trivially_copyable<PlanState>::value, "PlanState is copied for every branch");
+
+//
+// Autopilot: drives the bike for soak tests and the menu's attract mode.
+// Every REPLAN_STEPS simulation steps it runs a beam search over the next
+// DEPTH * SEGMENT_STEPS * MODEL_DT seconds: each branch holds one of the
+// lane change / boost / brake actions for a segment, the BEAM_WIDTH best
+// branches after each segment are expanded again, and the first action of
+// the best one is driven until the next plan.
+//
+// The model steps at MODEL_DT with the simulation's own speed rules and
+// whole-box crashes swept over each step (never closer than the pixel-exact
+// test), ignores trees and the finish line, and only knows about chunks
+// already generated. It only depends on the simulation's state, so a race
+// driven by the autopilot records and replays like any other.
+//
+class Autopilot {
+public:
+    static constexpr float MODEL_DT = 4.f * RaceSimulation::STEP_DT;
+    static const int SEGMENT_STEPS = 6;   // 0.2 s per decision
+    static const int DEPTH = 10;          // 2 s ahead
+    static const int BEAM_WIDTH = 12;
+    static const int ACTIONS = 9;         // {left, stay, right} x {cruise, boost, brake}
+    static const int REPLAN_STEPS = 6;    // 20 plans per simulated second
+
+    // Forget the current plan; the next drive() plans afresh.
+    void reset() { m_sincePlan = 0; }
+
+    // Input for the next step of sim. Call once per step.
+    RaceInput drive(const RaceSimulation &sim) {
+        if (m_sincePlan == 0)
+            plan(sim);
+        RaceInput in = m_action;
+        if (m_sincePlan != 0)
+            in.laneChange = 0;  // lane changes go to the first step only
+        m_sincePlan = (m_sincePlan + 1) % REPLAN_STEPS;
+        return in;
+    }
+
+    // Branches (segments simulated) the last plan looked at.
+    int branchesLastPlan() const { return m_branches; }
+
+    //
+    // Captures the parts of sim the model needs into track (everything that
+    // stays put along a branch) and state (everything else).
+    //
+    static void capture(const RaceSimulation &sim, float horizon, PlanTrack &track, PlanState &state) {
+        const RaceConfig &cfg = sim.cfg;
+        track.cfg = cfg;
+        SimRect pb = sim.playerBounds();
+        track.playerY = sim.playerY;
+        track.playerW = pb.width;
+        track.playerH = pb.height;
+        for (int l = 0; l < cfg.lanes; ++l)
+            track.laneX[l] = sim.laneCenter(l) - pb.width / 2.f;
+
+        state = PlanState();
+        state.state = sim.state;
+        state.playerLane = sim.playerLane;
+        state.lives = sim.lives;
+        state.score = sim.score;
+        state.stamina = sim.stamina;
+        state.playerWorldSpeed = sim.playerWorldSpeed;
+        state.distanceTraveled = sim.distanceTraveled;
+        state.hitTime = sim.hitTime;
+        state.triedWhileExhausted = sim.triedWhileExhausted;
+        state.raceFinished = sim.raceFinished;
+        state.trackPos = sim.trackPos;
+        state.lastRowAt = sim.lastRowAt;
+
+        // Obstacles on the road nearest the player (ahead, or behind it where
+        // braking could bring them back), then the ones to come.
+        int n = 0;
+        const EntityPool<RaceSimulation::MAX_OBSTACLES> &obstacles = sim.obstacles;
+        nearest(obstacles, cfg.lanes, pb.top + pb.height, true, PlanTrack::MAX_OBSTACLES, [&](int i) {
+            track.obstacleX[n] = obstacles.x[i];
+            track.obstacleW[n] = 2.f * obstacles.hw[i];
+            track.obstacleH[n] = 2.f * obstacles.hh[i];
+            track.obstacleAt[n] = 0.f;
+            state.obstacleY[n] = obstacles.y[i];
+            state.obstacleLive |= std::uint64_t(1) << n;
+            if (i == obstacles.newest())
+                state.newestObstacle = n;
+            ++n;
+        });
+        state.obstaclesReleased = n;
+        float upTo = sim.trackPos + cfg.maxSpeed * horizon;
+        sim.track.peek(TRACK_OBSTACLES, upTo, [&](const TrackItem &item) {
+            if (n == PlanTrack::MAX_OBSTACLES)
+                return;
+            float ow = cfg.obstacles[item.kind].w * cfg.obstacleScale;
+            track.obstacleX[n] = sim.laneCenter(item.lane) - ow / 2.f;
+            track.obstacleW[n] = ow;
+            track.obstacleH[n] = cfg.obstacles[item.kind].h * cfg.obstacleScale;
+            track.obstacleAt[n] = item.at;
+            ++n;
+        });
+        track.obstacleCount = n;
+
+        // Collectibles not yet past the player, nearest first, then the ones to come.
+        int p = 0;
+        auto addLive = [&](const auto &pool, bool coin) {
+            nearest(pool, cfg.lanes, pb.top + pb.height, false, PlanTrack::MAX_PICKUPS - p, [&](int i) {
+                track.pickupX[p] = pool.x[i];
+                track.pickupY[p] = pool.y[i];
+                track.pickupW[p] = 2.f * pool.hw[i];
+                track.pickupH[p] = 2.f * pool.hh[i];
+                track.pickupAt[p] = 0.f;
+                track.pickupIsCoin[p] = coin;
+                state.pickupReleased |= 1u << p;
+                state.pickupLive |= 1u << p;
+                ++p;
+            });
+        };
+        addLive(sim.bottles, false);
+        addLive(sim.coins, true);
+        auto addPending = [&](TrackItemType type, const SpriteSize &size, float scale) {
+            sim.track.peek(type, upTo, [&](const TrackItem &item) {
+                if (p == PlanTrack::MAX_PICKUPS)
+                    return;
+                float w = size.w * scale;
+                track.pickupX[p] = sim.laneCenter(item.lane) - w / 2.f;
+                track.pickupW[p] = w;
+                track.pickupH[p] = size.h * scale;
+                track.pickupY[p] = -item.at - track.pickupH[p];  // as RaceSimulation::releaseTop
+                track.pickupAt[p] = item.at;
+                track.pickupIsCoin[p] = type == TRACK_COINS;
+                ++p;
+            });
+        };
+        addPending(TRACK_BOTTLES, cfg.bottle, cfg.bottleScale);
+        addPending(TRACK_COINS, cfg.coin, cfg.coinScale);
+        track.pickupCount = p;
+    }
+
+    //
+    // One model step, in the simulation's order: lane, speed, obstacles
+    // (movement, rows coming in, crash, leaving), crash blink, collectibles.
+    //
+    static void step(const PlanTrack &t, PlanState &s, const RaceInput &in, float dt) {
+        if (s.state != GAME && s.state != HIT)
+            return;
+        const RaceConfig &cfg = t.cfg;
+        s.playerLane = std::max(0, std::min(cfg.lanes - 1, s.playerLane + in.laneChange));
+        RaceSimulation::updateSpeed(cfg, s, in, dt);
+        float scroll = s.playerWorldSpeed * dt;
+        s.trackPos += scroll;
+        float viewTop = -s.trackPos;
+        SimRect pb = { t.laneX[s.playerLane], t.playerY + viewTop, t.playerW, t.playerH };
+
+        // move is relative to the view (and the player), as in the simulation.
+        float move = (s.braking ? -cfg.obstacleSpeed : cfg.obstacleSpeed) * dt;
+        for (std::uint64_t live = s.obstacleLive; live; live &= live - 1)
+            s.obstacleY[lowestBit(live)] += move - scroll;
+        while (s.obstaclesReleased < t.obstacleCount) {
+            int i = s.obstaclesReleased;
+            if (t.obstacleAt[i] > s.trackPos)
+                break;
+            if (cfg.minGapScale > 0.f && t.obstacleAt[i] != s.lastRowAt && s.newestObstacle >= 0 &&
+                s.obstacleY[s.newestObstacle] - viewTop <= 150.f * cfg.minGapScale)
+                break;
+            s.obstacleY[i] = viewTop - t.obstacleH[i] - 50.f;
+            s.obstacleLive |= std::uint64_t(1) << i;
+            s.newestObstacle = i;
+            s.lastRowAt = t.obstacleAt[i];
+            ++s.obstaclesReleased;
+        }
+        for (std::uint64_t live = s.obstacleLive; live; live &= live - 1) {
+            int i = lowestBit(live);
+            // Swept over the step, so a coarse step can't jump past a crash.
+            SimRect ob = { t.obstacleX[i], s.obstacleY[i] - std::max(move, 0.f), t.obstacleW[i], t.obstacleH[i] + std::abs(move) };
+            bool crash = s.state == GAME && pb.intersects(ob);
+            if (crash) {
+                s.lives--;
+                if (s.lives <= 0) s.state = MENU; else { s.state = HIT; s.hitTime = 0.f; }
+            } else if (s.obstacleY[i] - viewTop > cfg.viewHeight) {
+                s.score += 10;
+            } else {
+                continue;
+            }
+            s.obstacleLive &= ~(std::uint64_t(1) << i);
+            if (s.newestObstacle == i)
+                s.newestObstacle = -1;
+        }
+
+        if (s.state == HIT) {
+            s.hitTime += dt;
+            if (s.hitTime >= cfg.hitDuration)
+                s.state = GAME;
+        }
+
+        for (int i = 0; i < t.pickupCount; ++i) {
+            std::uint32_t bit = 1u << i;
+            if (!(s.pickupReleased & bit)) {
+                if (t.pickupAt[i] > s.trackPos)
+                    continue;
+                s.pickupReleased |= bit;
+                s.pickupLive |= bit;
+            } else if (!(s.pickupLive & bit)) {
+                continue;
+            }
+            SimRect box = { t.pickupX[i], t.pickupY[i], t.pickupW[i], t.pickupH[i] };
+            if (pb.intersects(box)) {
+                if (t.pickupIsCoin[i]) s.score += 100;
+                else s.stamina = std::min(cfg.maxStamina, s.stamina + cfg.bottleStamina);
+                s.pickupLive &= ~bit;
+            } else if (box.top - viewTop > cfg.viewHeight) {
+                s.pickupLive &= ~bit;
+            }
+        }
+    }
+
+private:
+    //
+    // Calls f(i) for up to `max` entities of pool, nearest to `bottom` (the
+    // player's bottom edge) first: the ones above it and, with `behind`, the
+    // ones below. Walks each lane's index outwards from bottom, so a crowded
+    // pool costs max steps per lane, not a pass over everything, and what
+    // doesn't fit is the farthest away.
+    //
+    template <int N, typename F>
+    static void nearest(const EntityPool<N> &pool, int lanes, float bottom, bool behind, int max, F f) {
+        int up[LaneIndex<N>::MAX_LANES], down[LaneIndex<N>::MAX_LANES];
+        for (int l = 0; l < lanes; ++l) {
+            up[l] = pool.lanes.firstAbove(l, bottom, pool.y);
+            down[l] = behind ? up[l] - 1 : -1;
+        }
+        for (int n = 0; n < max; ++n) {
+            int lane = -1;
+            bool ahead = true;
+            float best = 0.f;
+            for (int l = 0; l < lanes; ++l) {
+                if (up[l] < pool.lanes.count(l)) {
+                    float d = bottom - pool.y[pool.lanes.at(l, up[l])];
+                    if (lane < 0 || d < best) { lane = l; ahead = true; best = d; }
+                }
+                if (down[l] >= 0) {
+                    float d = pool.y[pool.lanes.at(l, down[l])] - bottom;
+                    if (lane < 0 || d < best) { lane = l; ahead = false; best = d; }
+                }
+            }
+            if (lane < 0)
+                return;
+            f(pool.lanes.at(lane, ahead ? up[lane]++ : down[lane]--));
+        }
+    }
+
+    static int lowestBit(std::uint64_t v) {
+        int i = 0;
+        while (!(v & 1)) { v >>= 1; ++i; }
+        return i;
+    }
+
+    static RaceInput action(int a) {
+        RaceInput in;
+        in.laneChange = a % 3 - 1;
+        in.boost = a / 3 == 1;
+        in.brake = a / 3 == 2;
+        return in;
+    }
+
+    // How good a branch is: crashes first, then coins and passed obstacles,
+    // then ground covered, then stamina in hand.
+    float evaluate(const PlanState &s) const {
+        if (s.state != GAME && s.state != HIT)
+            return -1e9f;
+        return -5000.f * (m_rootLives - s.lives) + s.score + 0.1f * s.distanceTraveled + 10.f * s.stamina;
+    }
+
+    void plan(const RaceSimulation &sim) {
+        PROFILE_SCOPE(ZONE_AUTOPILOT);
+        const float segment = SEGMENT_STEPS * MODEL_DT;
+        capture(sim, DEPTH * segment, m_track, m_beam[0]);
+        m_rootLives = m_beam[0].lives;
+        int beam = 1;
+        m_branches = 0;
+        for (int depth = 0; depth < DEPTH; ++depth) {
+            int children = 0;
+            for (int b = 0; b < beam; ++b) {
+                const PlanState &parent = m_beam[b];
+                if (parent.state != GAME && parent.state != HIT)
+                    continue;
+                for (int a = 0; a < ACTIONS; ++a) {
+                    RaceInput in = action(a);
+                    int lane = parent.playerLane + in.laneChange;
+                    if (lane < 0 || lane >= m_track.cfg.lanes)
+                        continue;  // same as staying
+                    if (in.boost && parent.stamina < m_track.cfg.minStaminaToBoost)
+                        continue;  // same as cruising
+                    PlanState &child = m_children[children++];
+                    child = parent;
+                    if (depth == 0)
+                        child.first = in;
+                    for (int k = 0; k < SEGMENT_STEPS; ++k) {
+                        step(m_track, child, in, MODEL_DT);
+                        in.laneChange = 0;
+                    }
+                    child.value = evaluate(child);
+                }
+            }
+            m_branches += children;
+            if (children == 0)
+                break;
+            for (int c = 0; c < children; ++c)
+                m_order[c] = c;
+            beam = children < BEAM_WIDTH ? children : BEAM_WIDTH;
+            std::partial_sort(m_order, m_order + beam, m_order + children,
+                              [&](int a, int b) { return m_children[a].value > m_children[b].value; });
+            for (int b = 0; b < beam; ++b)
+                m_beam[b] = m_children[m_order[b]];
+        }
+        m_action = m_beam[0].first;  // the beam is best first
+    }
+
+    PlanTrack m_track;
+    PlanState m_beam[BEAM_WIDTH];
+    PlanState m_children[BEAM_WIDTH * ACTIONS];
+    int m_order[BEAM_WIDTH * ACTIONS];
+    int m_rootLives = 0;
+    int m_branches = 0;
+    int m_sincePlan = 0;
+    RaceInput m_action;
+};
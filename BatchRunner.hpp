@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "JobSystem.hpp"
+#include "RaceSimulation.hpp"
+
+//
+// Windowless balance sweeps: every combination of a grid of RaceConfig
+// values is raced with a range of seeds, the races spread over a
+// JobSystem (each chunk of races gets its own RaceSimulation), and the
+// results are aggregated per combination into score, lives lost, finish
+// time and pickup-rate distributions. The results depend only on the grid,
+// the seeds and the driver, not on the number of threads.
+//
+
+// A RaceConfig value a sweep can vary.
+struct SweepParam {
+    const char *name;
+    float RaceConfig::*field;
+};
+
+inline const std::vector<SweepParam> &sweepParams() {
+    static const std::vector<SweepParam> params = {
+        { "staminaDrain",  &RaceConfig::staminaDrain },
+        { "staminaRegen",  &RaceConfig::staminaRegen },
+        { "bottleStamina", &RaceConfig::bottleStamina },
+        { "accel",         &RaceConfig::accel },
+        { "maxSpeed",      &RaceConfig::maxSpeed },
+        { "defaultSpeed",  &RaceConfig::defaultSpeed },
+        { "obstacleSpeed", &RaceConfig::obstacleSpeed },
+        { "obstacleRate",  &RaceConfig::obstacleRate },
+        { "bottleRate",    &RaceConfig::bottleRate },
+        { "coinRate",      &RaceConfig::coinRate },
+        { "treeRate",      &RaceConfig::treeRate },
+    };
+    return params;
+}
+
+inline const SweepParam *findSweepParam(const std::string &name) {
+    for (const SweepParam &p : sweepParams())
+        if (name == p.name)
+            return &p;
+    return nullptr;
+}
+
+// One axis of the grid: a parameter and the values it takes.
+struct SweepAxis {
+    const SweepParam *param = nullptr;
+    std::vector<float> values;
+};
+
+//
+// Stand-in for a player: keeps to a lane with no obstacle coming within
+// LOOKAHEAD px, moving one lane at a time towards the closest clear one,
+// and boosts while more than half the stamina is left.
+//
+inline RaceInput sweepDriver(const RaceSimulation &sim) {
+    const float LOOKAHEAD = 250.f;
+    SimRect pb = sim.playerBounds();
+    float top = pb.top - LOOKAHEAD;
+    float bottom = pb.top + pb.height;
+    bool blocked[LaneIndex<RaceSimulation::MAX_OBSTACLES>::MAX_LANES] = {};
+    for (int i = 0; i < sim.obstacles.size(); ++i) {
+        float y = sim.obstacles.y[i];
+        if (y + 2.f * sim.obstacles.hh[i] > top && y < bottom)
+            blocked[sim.obstacles.lane[i]] = true;
+    }
+
+    RaceInput in;
+    int lane = sim.playerLane;
+    if (blocked[lane]) {
+        for (int d = 1; d < sim.cfg.lanes; ++d) {
+            if (lane - d >= 0 && !blocked[lane - d]) { in.laneChange = -1; break; }
+            if (lane + d < sim.cfg.lanes && !blocked[lane + d]) { in.laneChange = 1; break; }
+        }
+    }
+    in.boost = !blocked[lane] && sim.stamina > 0.5f * sim.cfg.maxStamina;
+    return in;
+}
+
+// How one race went.
+struct SweepRace {
+    int score = 0;
+    int livesLost = 0;
+    bool finished = false;
+    float seconds = 0.f;  // race time until it ended (or was cut off)
+    int coins = 0, bottles = 0;
+};
+
+// Distribution summary of one metric.
+struct SweepDistribution {
+    double mean = 0.0, p10 = 0.0, p50 = 0.0, p90 = 0.0;
+
+    static SweepDistribution of(std::vector<float> v) {
+        SweepDistribution d;
+        if (v.empty())
+            return d;
+        std::sort(v.begin(), v.end());
+        double sum = 0.0;
+        for (float x : v)
+            sum += x;
+        d.mean = sum / v.size();
+        d.p10 = v[(v.size() - 1) / 10];
+        d.p50 = v[(v.size() - 1) / 2];
+        d.p90 = v[(v.size() - 1) * 9 / 10];
+        return d;
+    }
+};
+
+// Aggregate of every seed raced with one combination of values.
+struct SweepResult {
+    std::vector<float> values;  // one per axis
+    int races = 0, finished = 0;
+    SweepDistribution score, livesLost, finishSeconds, coinsPerMinute, bottlesPerMinute;
+};
+
+class BatchRunner {
+public:
+    BatchRunner(const RaceConfig &base, const CollisionMasks *masks) : m_base(base), m_masks(masks) {}
+
+    //
+    // Races every combination of the axes' values with seeds
+    // [firstSeed, firstSeed + seedCount), each for at most maxSeconds.
+    //
+    std::vector<SweepResult> run(const std::vector<SweepAxis> &axes, std::uint64_t firstSeed, int seedCount,
+                                 float maxSeconds, JobSystem &jobs) const {
+        int combos = 1;
+        for (const SweepAxis &a : axes)
+            combos *= static_cast<int>(a.values.size());
+        int total = combos * seedCount;
+        std::vector<SweepRace> races(total);
+        long maxSteps = static_cast<long>(maxSeconds / RaceSimulation::STEP_DT);
+
+        // Enough chunks to keep every worker busy, each with its own race state.
+        int grain = std::max(1, total / std::max(1, 8 * (jobs.workerCount() + 1)));
+        jobs.parallelFor(total, grain, [&](int begin, int end) {
+            std::unique_ptr<RaceSimulation> sim(new RaceSimulation);
+            sim->masks = m_masks;
+            for (int r = begin; r < end; ++r) {
+                sim->cfg = config(axes, r / seedCount);
+                sim->reset(firstSeed + r % seedCount);
+                races[r] = race(*sim, maxSteps);
+            }
+        });
+
+        std::vector<SweepResult> results(combos);
+        for (int c = 0; c < combos; ++c) {
+            SweepResult &res = results[c];
+            RaceConfig cfg = config(axes, c);
+            for (const SweepAxis &a : axes)
+                res.values.push_back(cfg.*(a.param->field));
+            std::vector<float> score, lost, finish, coins, bottles;
+            for (int s = 0; s < seedCount; ++s) {
+                const SweepRace &r = races[c * seedCount + s];
+                float minutes = std::max(r.seconds, RaceSimulation::STEP_DT) / 60.f;
+                score.push_back(static_cast<float>(r.score));
+                lost.push_back(static_cast<float>(r.livesLost));
+                if (r.finished)
+                    finish.push_back(r.seconds);
+                coins.push_back(r.coins / minutes);
+                bottles.push_back(r.bottles / minutes);
+            }
+            res.races = seedCount;
+            res.finished = static_cast<int>(finish.size());
+            res.score = SweepDistribution::of(score);
+            res.livesLost = SweepDistribution::of(lost);
+            res.finishSeconds = SweepDistribution::of(finish);
+            res.coinsPerMinute = SweepDistribution::of(coins);
+            res.bottlesPerMinute = SweepDistribution::of(bottles);
+        }
+        return results;
+    }
+
+    static bool writeCsv(const std::string &path, const std::vector<SweepAxis> &axes,
+                         const std::vector<SweepResult> &results) {
+        std::FILE *f = std::fopen(path.c_str(), "w");
+        if (!f)
+            return false;
+        const char *metrics[] = { "score", "lives_lost", "finish_s", "coins_per_min", "bottles_per_min" };
+        for (const SweepAxis &a : axes)
+            std::fprintf(f, "%s,", a.param->name);
+        std::fprintf(f, "races,finished");
+        for (const char *m : metrics)
+            std::fprintf(f, ",%s_mean,%s_p10,%s_p50,%s_p90", m, m, m, m);
+        std::fprintf(f, "\n");
+        for (const SweepResult &r : results) {
+            for (float v : r.values)
+                std::fprintf(f, "%g,", v);
+            std::fprintf(f, "%d,%d", r.races, r.finished);
+            for (const SweepDistribution *d : { &r.score, &r.livesLost, &r.finishSeconds, &r.coinsPerMinute, &r.bottlesPerMinute })
+                std::fprintf(f, ",%.3f,%.3f,%.3f,%.3f", d->mean, d->p10, d->p50, d->p90);
+            std::fprintf(f, "\n");
+        }
+        return std::fclose(f) == 0;
+    }
+
+private:
+    // Config of combination c; the first axis varies slowest.
+    RaceConfig config(const std::vector<SweepAxis> &axes, int c) const {
+        RaceConfig cfg = m_base;
+        for (int a = static_cast<int>(axes.size()) - 1; a >= 0; --a) {
+            int n = static_cast<int>(axes[a].values.size());
+            cfg.*(axes[a].param->field) = axes[a].values[c % n];
+            c /= n;
+        }
+        return cfg;
+    }
+
+    static SweepRace race(RaceSimulation &sim, long maxSteps) {
+        long steps = 0;
+        while ((sim.state == GAME || sim.state == HIT) && steps < maxSteps) {
+            sim.step(sweepDriver(sim), RaceSimulation::STEP_DT);
+            ++steps;
+        }
+        SweepRace r;
+        r.score = sim.score;
+        r.livesLost = sim.cfg.startLives - std::max(0, sim.lives);
+        r.finished = sim.state == FINISH;
+        r.seconds = steps * RaceSimulation::STEP_DT;
+        r.coins = sim.coinsCollected;
+        r.bottles = sim.bottlesCollected;
+        return r;
+    }
+
+    RaceConfig m_base;
+    const CollisionMasks *m_masks;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "RaceSimulation.hpp"
+
+//
+// Preset stress scenarios for --bench. Each one tunes the race config and
+// scripts the input frame by frame, so a run does exactly the same work on
+// every build and the frame times can be compared directly.
+//
+struct BenchScenario {
+    const char *name;
+    const char *description;
+    void (*tune)(RaceConfig &cfg);
+    RaceInput (*input)(int frame);
+    int resizeEvery;  // resize the window every n frames (0 = never)
+};
+
+namespace bench {
+
+// Weaves across the lanes, boosting now and then.
+inline RaceInput weave(int frame) {
+    RaceInput in;
+    in.laneChange = frame % 40 == 0 ? ((frame / 40) % 4 < 2 ? 1 : -1) : 0;
+    in.boost = frame % 300 < 60;
+    return in;
+}
+
+inline RaceInput fullBoost(int frame) {
+    RaceInput in = weave(frame);
+    in.boost = true;
+    return in;
+}
+
+inline void normal(RaceConfig &) {}
+
+// Crashes must not end the run early.
+inline void endless(RaceConfig &cfg) {
+    cfg.startLives = 1 << 30;
+    cfg.numTiles = 1 << 20;
+}
+
+// Without the minimum gaps the rates alone space the items, and rows come
+// in without waiting for the one before: the pools really fill up. A rate
+// of r places about 4.3 r items per track chunk at defaultSpeed (5.3 r
+// obstacles, rows being 1.25 on average); these stay well under
+// TrackChunk::MAX_ITEMS so the load is steady, not cut off at each chunk.
+inline void obstacleWaves(RaceConfig &cfg) {
+    endless(cfg);
+    cfg.minGapScale = 0.f;
+    cfg.obstacleRate = 80.f;
+    cfg.obstacleSpeed = 120.f;
+}
+
+inline void crowded(RaceConfig &cfg) {
+    endless(cfg);
+    cfg.minGapScale = 0.f;
+    cfg.treeRate = 100.f;
+    cfg.coinRate = 100.f;
+    cfg.bottleRate = 50.f;
+}
+
+// Stamina never runs out, so the player stays at maxSpeed.
+inline void maxSpeed(RaceConfig &cfg) {
+    endless(cfg);
+    cfg.staminaDrain = 0.f;
+    cfg.accel = 1e6f;
+}
+
+} // namespace bench
+
+inline const std::vector<BenchScenario> &benchScenarios() {
+    static const std::vector<BenchScenario> scenarios = {
+        { "race",      "normal race with scripted lane changes",  bench::normal,        bench::weave,     0 },
+        { "obstacles", "gapless obstacle rows, pool near full",   bench::obstacleWaves, bench::weave,     0 },
+        { "crowd",     "hundreds of trees, coins and bottles",    bench::crowded,       bench::weave,     0 },
+        { "boost",     "constant boosting at max speed",          bench::maxSpeed,      bench::fullBoost, 0 },
+        { "resize",    "window resized every 30 frames",          bench::endless,       bench::weave,     30 },
+    };
+    return scenarios;
+}
+
+inline const BenchScenario *findBenchScenario(const std::string &name) {
+    for (const BenchScenario &s : benchScenarios())
+        if (name == s.name)
+            return &s;
+    return nullptr;
+}
+
+//
+// Frame-time statistics of a run, in milliseconds.
+//
+struct BenchStats {
+    double mean = 0.0, p50 = 0.0, p99 = 0.0, worst = 0.0;
+
+    static BenchStats of(std::vector<float> frameMs) {
+        BenchStats s;
+        if (frameMs.empty())
+            return s;
+        std::sort(frameMs.begin(), frameMs.end());
+        double sum = 0.0;
+        for (float f : frameMs)
+            sum += f;
+        s.mean = sum / frameMs.size();
+        s.p50 = frameMs[(frameMs.size() - 1) / 2];
+        s.p99 = frameMs[static_cast<size_t>((frameMs.size() - 1) * 0.99)];
+        s.worst = frameMs.back();
+        return s;
+    }
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "RaceConfig.hpp"
+
+//
+// 1-bit opacity mask of a sprite at its draw scale: bit x of row y is set
+// where the scaled sprite is opaque (alpha >= 128, sampled at the pixel
+// centre). Rows are packed into 64-bit words, bit i of word k being pixel
+// 64k + i, so two masks are tested against each other a word at a time.
+// Built once at load time from RGBA pixels; no SFML dependency.
+//
+struct CollisionMask {
+    int width = 0, height = 0;
+    int words = 0;  // words per row
+    std::vector<std::uint64_t> bits;
+
+    static CollisionMask fromRgba(const std::uint8_t *rgba, int srcW, int srcH, float scale) {
+        CollisionMask m;
+        if (!rgba || srcW <= 0 || srcH <= 0 || scale <= 0.f)
+            return m;
+        m.width = std::max(1, static_cast<int>(std::ceil(srcW * scale)));
+        m.height = std::max(1, static_cast<int>(std::ceil(srcH * scale)));
+        m.words = (m.width + 63) / 64;
+        m.bits.assign(static_cast<std::size_t>(m.words) * m.height, 0);
+        for (int y = 0; y < m.height; ++y) {
+            int sy = std::min(srcH - 1, static_cast<int>((y + 0.5f) / scale));
+            for (int x = 0; x < m.width; ++x) {
+                int sx = std::min(srcW - 1, static_cast<int>((x + 0.5f) / scale));
+                if (rgba[(static_cast<std::size_t>(sy) * srcW + sx) * 4 + 3] >= 128)
+                    m.bits[static_cast<std::size_t>(y) * m.words + x / 64] |= std::uint64_t(1) << (x % 64);
+            }
+        }
+        return m;
+    }
+
+    bool empty() const { return bits.empty(); }
+
+    //
+    // True if any opaque pixel of this mask (top-left at the origin) meets one
+    // of `other` with its top-left at (dx, dy): for every shared row, this
+    // row's words are ANDed with the other's row shifted into alignment.
+    //
+    bool overlaps(const CollisionMask &other, int dx, int dy) const {
+        int y0 = std::max(0, dy), y1 = std::min(height, dy + other.height);
+        int x0 = std::max(0, dx), x1 = std::min(width, dx + other.width);
+        if (y0 >= y1 || x0 >= x1)
+            return false;
+        int k0 = x0 / 64, k1 = (x1 - 1) / 64;
+        for (int y = y0; y < y1; ++y) {
+            const std::uint64_t *a = &bits[static_cast<std::size_t>(y) * words];
+            const std::uint64_t *b = &other.bits[static_cast<std::size_t>(y - dy) * other.words];
+            for (int k = k0; k <= k1; ++k)
+                if (a[k] & other.rowBits(b, k * 64 - dx))
+                    return true;
+        }
+        return false;
+    }
+
+private:
+    // 64 pixels of a row starting at pixel `from` (may lie partly outside the row).
+    std::uint64_t rowBits(const std::uint64_t *row, int from) const {
+        int k = from >= 0 ? from / 64 : -((63 - from) / 64);
+        int shift = from - k * 64;  // 0..63
+        std::uint64_t lo = k >= 0 && k < words ? row[k] : 0;
+        std::uint64_t hi = k + 1 >= 0 && k + 1 < words ? row[k + 1] : 0;
+        return shift == 0 ? lo : (lo >> shift) | (hi << (64 - shift));
+    }
+};
+
+//
+// Masks of everything the player can crash into, at the config's draw scales.
+//
+struct CollisionMasks {
+    CollisionMask player;
+    CollisionMask obstacles[RaceConfig::OBSTACLE_KINDS];
+
+    bool complete() const {
+        if (player.empty())
+            return false;
+        for (const CollisionMask &m : obstacles)
+            if (m.empty())
+                return false;
+        return true;
+    }
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+
+#include "LaneIndex.hpp"
+
+//
+// Fixed-capacity entity storage in structure-of-arrays form. Every field of
+// every slot lives inline in its own contiguous array, allocated once with the
+// owner; spawn() takes the next free slot and remove() moves the last live
+// entity into the hole (swap-remove), so neither ever allocates or shifts the
+// rest. Iteration order is therefore not spawn order; the most recently
+// spawned entity is still available through newest().
+//
+// Positions are the top-left corner in view pixels (like sf::Sprite), the
+// half-extents are the scaled texture size / 2, computed once at spawn.
+// `lanes` indexes the live entities by lane and height and is kept up to date
+// by spawn() and remove().
+//
+template <int Capacity>
+struct EntityPool {
+    static const int CAPACITY = Capacity;
+
+    float x[Capacity];
+    float y[Capacity];
+    float prevY[Capacity];  // y one step earlier, for render interpolation
+    float hw[Capacity];     // half width
+    float hh[Capacity];     // half height
+    std::uint8_t lane[Capacity];
+    std::uint8_t kind[Capacity];  // texture variant for trees and obstacles
+    LaneIndex<Capacity> lanes;
+
+    // Returns the new slot index, or -1 when the pool is full.
+    int spawn(float px, float py, float halfW, float halfH, int laneIndex, int kindIndex) {
+        if (m_count == Capacity)
+            return -1;
+        int i = m_count++;
+        x[i] = px;
+        y[i] = prevY[i] = py;
+        hw[i] = halfW;
+        hh[i] = halfH;
+        lane[i] = static_cast<std::uint8_t>(laneIndex);
+        kind[i] = static_cast<std::uint8_t>(kindIndex);
+        lanes.insert(laneIndex, i, y);
+        if (halfW > m_maxHw) m_maxHw = halfW;
+        if (halfH > m_maxHh) m_maxHh = halfH;
+        m_newest = i;
+        ++m_version;
+        return i;
+    }
+
+    // Removes the entity at index i by moving the last one into its slot.
+    void remove(int i) {
+        int last = m_count - 1;
+        lanes.erase(lane[i], i, y);
+        if (i != last) {
+            lanes.rename(lane[last], last, i, y);
+            x[i] = x[last];
+            y[i] = y[last];
+            prevY[i] = prevY[last];
+            hw[i] = hw[last];
+            hh[i] = hh[last];
+            lane[i] = lane[last];
+            kind[i] = kind[last];
+        }
+        if (m_newest == i)
+            m_newest = -1;
+        else if (m_newest == last)
+            m_newest = i;
+        m_count = last;
+        ++m_version;
+    }
+
+    void clear() {
+        m_count = 0;
+        m_newest = -1;
+        m_maxHw = m_maxHh = 0.f;
+        lanes.clear();
+        ++m_version;
+    }
+
+    // Moves every entity down by dy.
+    void move(float dy) {
+        for (int i = 0; i < m_count; ++i) {
+            prevY[i] = y[i];
+            y[i] += dy;
+        }
+    }
+
+    // Removes every entity whose top is below `limit` (off the bottom of the
+    // view); they sit at the bottom end of their lane. Returns how many.
+    int removeBelow(float limit) {
+        int n = 0;
+        for (int l = 0; l < LaneIndex<Capacity>::MAX_LANES; ++l) {
+            while (lanes.count(l) > 0 && y[lanes.at(l, 0)] > limit) {
+                remove(lanes.at(l, 0));
+                ++n;
+            }
+        }
+        return n;
+    }
+
+    //
+    // Calls f(i) for every entity in lanes [firstLane, lastLane] whose box may
+    // reach into [top, bottom) vertically, using the per-lane index. f does the
+    // exact test and returns true to stop the search; returns whether it did.
+    //
+    template <typename F>
+    bool query(int firstLane, int lastLane, float top, float bottom, F f) const {
+        for (int l = firstLane; l <= lastLane; ++l)
+            if (lanes.query(l, top - 2.f * m_maxHh, bottom, y, f))
+                return true;
+        return false;
+    }
+
+    // Largest half width / half height spawned since the last clear().
+    float maxHalfWidth() const { return m_maxHw; }
+    float maxHalfHeight() const { return m_maxHh; }
+
+    // Index of the last entity handed out by spawn(), or -1 if it has been removed since.
+    int newest() const { return m_newest; }
+
+    int size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+    bool full() const { return m_count == Capacity; }
+
+    // Changes whenever entities are spawned or removed, not when they move.
+    std::uint32_t version() const { return m_version; }
+
+    // Writes the live entities and the lane index to w (see RaceHistory);
+    // load() puts them back in the same slots and lane order.
+    template <typename Writer>
+    void save(Writer &w) const {
+        w(m_count);
+        w(m_newest);
+        w(m_maxHw);
+        w(m_maxHh);
+        w(x, m_count);
+        w(y, m_count);
+        w(prevY, m_count);
+        w(hw, m_count);
+        w(hh, m_count);
+        w(lane, m_count);
+        w(kind, m_count);
+        lanes.save(w);
+    }
+
+    template <typename Reader>
+    void load(Reader &r) {
+        r(m_count);
+        r(m_newest);
+        r(m_maxHw);
+        r(m_maxHh);
+        r(x, m_count);
+        r(y, m_count);
+        r(prevY, m_count);
+        r(hw, m_count);
+        r(hh, m_count);
+        r(lane, m_count);
+        r(kind, m_count);
+        lanes.load(r);
+        ++m_version;
+    }
+
+private:
+    int m_count = 0;
+    int m_newest = -1;
+    float m_maxHw = 0.f, m_maxHh = 0.f;
+    std::uint32_t m_version = 0;
+};
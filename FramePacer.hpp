@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+//
+// Histogram of frame-interval error: how far each frame's interval was from
+// the target interval, in BIN_MS wide bins from MIN_MS to MAX_MS (anything
+// outside lands in the first / last bin). Early frames are negative.
+//
+class FrameHistogram {
+public:
+    static constexpr float MIN_MS = -2.f;
+    static constexpr float MAX_MS = 10.f;
+    static constexpr float BIN_MS = 0.25f;
+    static const int BINS = static_cast<int>((MAX_MS - MIN_MS) / BIN_MS);
+
+    void add(float errorMs) {
+        int b = static_cast<int>(std::floor((errorMs - MIN_MS) / BIN_MS));
+        ++m_bins[std::max(0, std::min(BINS - 1, b))];
+        ++m_count;
+        m_worst = std::max(m_worst, errorMs);
+    }
+
+    void clear() { *this = FrameHistogram(); }
+
+    std::uint64_t count() const { return m_count; }
+    std::uint64_t bin(int b) const { return m_bins[b]; }
+    static float binStart(int b) { return MIN_MS + b * BIN_MS; }
+    float worst() const { return m_worst; }
+
+    // Upper edge of the bin holding the p-th fraction of the frames.
+    float percentile(float p) const {
+        std::uint64_t want = static_cast<std::uint64_t>(std::ceil(p * m_count));
+        std::uint64_t seen = 0;
+        for (int b = 0; b < BINS; ++b) {
+            seen += m_bins[b];
+            if (seen >= want && seen > 0)
+                return binStart(b) + BIN_MS;
+        }
+        return MAX_MS;
+    }
+
+    // Fraction of the frames more than ms late.
+    float lateFraction(float ms) const {
+        if (m_count == 0)
+            return 0.f;
+        std::uint64_t late = 0;
+        for (int b = 0; b < BINS; ++b)
+            if (binStart(b) >= ms)
+                late += m_bins[b];
+        return static_cast<float>(late) / m_count;
+    }
+
+    // One line per non-empty bin: "  +0.25 ms  123".
+    std::string table() const {
+        std::string out;
+        char line[48];
+        for (int b = 0; b < BINS; ++b) {
+            if (m_bins[b] == 0)
+                continue;
+            std::snprintf(line, sizeof line, "%+7.2f ms  %llu\n", binStart(b),
+                          static_cast<unsigned long long>(m_bins[b]));
+            out += line;
+        }
+        return out;
+    }
+
+private:
+    std::uint64_t m_bins[BINS] = {};
+    std::uint64_t m_count = 0;
+    float m_worst = 0.f;
+};
+
+//
+// Frame pacer. wait() is called once per frame and returns when the next
+// frame is due: it sleeps until SPIN_MS before the deadline (the OS sleep
+// can overshoot by a millisecond or more) and spins the rest. Deadlines are
+// spaced exactly one interval apart, so an early or late frame doesn't shift
+// the ones after it; a frame more than an interval late starts a new
+// schedule instead of rushing to catch up.
+//
+// With vsync on, display() already waits for the refresh; the pacer then
+// only waits for targets below the refresh rate and measures the rest.
+// Target 0 means uncapped. Every interval's error goes into histogram().
+//
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr float SPIN_MS = 1.f;
+
+    void setTarget(unsigned fps) {
+        if (fps == m_fps)
+            return;
+        m_fps = fps;
+        m_skipSample = true;  // the interval spanning the change measures neither target
+        m_next = Clock::now();
+    }
+    unsigned target() const { return m_fps; }
+
+    // Refresh rate display() is synced to, 0 for none.
+    void setVsync(unsigned refreshHz) { m_vsyncHz = refreshHz; }
+
+    void wait() {
+        Clock::time_point now = Clock::now();
+        Clock::duration interval = intervalOf(m_fps);
+        bool paced = m_fps > 0 && (m_vsyncHz == 0 || m_fps < m_vsyncHz);
+
+        if (paced) {
+            m_next += interval;
+            if (now > m_next + interval) {
+                m_next = now;  // hopelessly late: start over from here
+            } else {
+                Clock::time_point spinFrom =
+                    m_next - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(SPIN_MS));
+                if (now < spinFrom)
+                    std::this_thread::sleep_until(spinFrom);
+                while (Clock::now() < m_next)
+                    std::this_thread::yield();
+                now = Clock::now();
+            }
+        }
+
+        // Error against the interval this frame was meant to take.
+        unsigned expected = paced ? m_fps : m_vsyncHz;  // 0: uncapped, nothing to measure against
+        if (m_hasLast && !m_skipSample && expected > 0) {
+            std::chrono::duration<float, std::milli> actual = now - m_last;
+            std::chrono::duration<float, std::milli> want = intervalOf(expected);
+            m_histogram.add(actual.count() - want.count());
+        }
+        m_skipSample = false;
+        m_hasLast = true;
+        m_last = now;
+    }
+
+    const FrameHistogram &histogram() const { return m_histogram; }
+    void clearHistogram() { m_histogram.clear(); }
+
+private:
+    static Clock::duration intervalOf(unsigned fps) {
+        return fps ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps))
+                   : Clock::duration::zero();
+    }
+
+    unsigned m_fps = 0;
+    unsigned m_vsyncHz = 0;
+    Clock::time_point m_next = Clock::now();
+    Clock::time_point m_last;
+    bool m_hasLast = false;
+    bool m_skipSample = true;
+    FrameHistogram m_histogram;
+};
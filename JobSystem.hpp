@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Small work-stealing job system for splitting a loop across cores.
+//
+// parallelFor() cuts [0, count) into chunks and deals them out to the
+// workers' own queues. A worker runs its queue newest-first and, once it is
+// empty, steals the oldest chunk from another worker's queue; the calling
+// thread steals as well until every chunk is done, so a parallelFor with no
+// workers (or nothing worth splitting) simply runs inline. Chunks must only
+// touch their own range; their results are as deterministic as the caller
+// makes the merge.
+//
+// Queues are fixed rings, so dispatching never allocates.
+//
+// It splits whole races (--sweep, see BatchRunner), not the steps of one.
+// A race step stays on the simulation thread: even the packed bench
+// scenarios keep under a thousand live entities, moving them all is a
+// fraction of a microsecond, and collisions, pickups and culling only
+// visit the few entities the per-lane index finds near the player or the
+// bottom of the view. No loop in a step is long enough to pay for waking
+// a worker; splitting one only makes sense again with timings from a
+// multi-core machine that show otherwise.
+//
+class JobSystem {
+public:
+    // Leaves a core each for the render and simulation threads.
+    static int defaultWorkers() {
+        int cores = static_cast<int>(std::thread::hardware_concurrency());
+        return std::max(0, cores - 2);
+    }
+
+    explicit JobSystem(int workers = defaultWorkers()) {
+        for (int i = 0; i < workers; ++i)
+            m_queues.emplace_back(new Queue);
+        for (int i = 0; i < workers; ++i)
+            m_threads.emplace_back([this, i] { work(i); });
+    }
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_quit = true;
+        }
+        m_wake.notify_all();
+        for (std::thread &t : m_threads)
+            t.join();
+    }
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    int workerCount() const { return static_cast<int>(m_threads.size()); }
+
+    //
+    // Calls f(begin, end) for consecutive chunks of at most `grain` indices
+    // covering [0, count), spread over the workers, and returns when all of
+    // them have run.
+    //
+    template <typename F>
+    void parallelFor(int count, int grain, const F &f) {
+        grain = std::max(1, grain);
+        if (m_queues.empty() || count <= grain) {
+            if (count > 0)
+                f(0, count);
+            return;
+        }
+
+        std::atomic<int> pending{ 0 };
+        Job job;
+        job.run = [](const void *fn, int begin, int end) { (*static_cast<const F *>(fn))(begin, end); };
+        job.fn = &f;
+        job.pending = &pending;
+
+        int worker = 0;
+        for (int begin = 0; begin < count; begin += grain) {
+            job.begin = begin;
+            job.end = std::min(count, begin + grain);
+            pending.fetch_add(1, std::memory_order_relaxed);
+            if (!m_queues[worker]->push(job))
+                execute(job);  // that queue is full: do it here
+            worker = (worker + 1) % static_cast<int>(m_queues.size());
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        // Help out until the last chunk is done.
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (!steal(job, 0))
+                std::this_thread::yield();
+            else
+                execute(job);
+        }
+    }
+
+private:
+    struct Job {
+        void (*run)(const void *fn, int begin, int end) = nullptr;
+        const void *fn = nullptr;
+        int begin = 0, end = 0;
+        std::atomic<int> *pending = nullptr;
+    };
+
+    // One worker's deque: the owner pops from the back, thieves take the front.
+    struct Queue {
+        static const int CAPACITY = 256;
+
+        bool push(const Job &job) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (count == CAPACITY)
+                return false;
+            jobs[(head + count++) % CAPACITY] = job;
+            return true;
+        }
+        bool popBack(Job &job) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (count == 0)
+                return false;
+            job = jobs[(head + --count) % CAPACITY];
+            return true;
+        }
+        bool popFront(Job &job) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (count == 0)
+                return false;
+            job = jobs[head];
+            head = (head + 1) % CAPACITY;
+            --count;
+            return true;
+        }
+
+        std::mutex mutex;
+        Job jobs[CAPACITY];
+        int head = 0, count = 0;
+    };
+
+    static void execute(const Job &job) {
+        job.run(job.fn, job.begin, job.end);
+        job.pending->fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    // Takes the oldest job of any queue, starting at queue `first`.
+    bool steal(Job &job, int first) {
+        int n = static_cast<int>(m_queues.size());
+        for (int k = 0; k < n; ++k)
+            if (m_queues[(first + k) % n]->popFront(job))
+                return true;
+        return false;
+    }
+
+    void work(int self) {
+        Job job;
+        unsigned seen = 0;
+        for (;;) {
+            if (m_queues[self]->popBack(job) || steal(job, self + 1)) {
+                execute(job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [&] { return m_quit || m_generation != seen; });
+            if (m_quit)
+                return;
+            seen = m_generation;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_sleepMutex;  // only for putting idle workers to sleep
+    std::condition_variable m_wake;
+    unsigned m_generation = 0;  // bumped by every parallelFor
+    bool m_quit = false;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+
+//
+// Per-lane spatial index over one EntityPool. For every lane it keeps the pool
+// indices of the entities in that lane ordered bottom to top (y descending).
+// Everything in a pool scrolls by the same amount each step, so the order
+// never changes once an entity is in: new entities enter near the top end,
+// entities leave at the bottom end, and both ends of the ring are O(1).
+// Lookups are a binary search on y inside one lane.
+//
+template <int Capacity>
+class LaneIndex {
+public:
+    static const int MAX_LANES = 8;
+    static_assert((Capacity & (Capacity - 1)) == 0, "LaneIndex capacity must be a power of two");
+
+    void clear() {
+        for (int l = 0; l < MAX_LANES; ++l)
+            m_head[l] = m_len[l] = 0;
+    }
+
+    int count(int lane) const { return m_len[lane]; }
+
+    // k-th entity of a lane counting from the bottom (largest y).
+    int at(int lane, int k) const { return m_ring[lane][(m_head[lane] + k) & MASK]; }
+
+    // Adds pool index i (at height y[i]) to its lane.
+    void insert(int lane, int i, const float *y) {
+        int p = m_len[lane]++;
+        // Entities spawn above everything else, so this loop rarely runs.
+        while (p > 0 && y[at(lane, p - 1)] < y[i]) {
+            slot(lane, p) = at(lane, p - 1);
+            --p;
+        }
+        slot(lane, p) = static_cast<std::int16_t>(i);
+    }
+
+    // Removes pool index i (still at height y[i]) from its lane.
+    void erase(int lane, int i, const float *y) {
+        int p = find(lane, i, y);
+        if (p < 0)
+            return;
+        int n = m_len[lane];
+        if (p < n / 2) {
+            for (; p > 0; --p)
+                slot(lane, p) = at(lane, p - 1);
+            m_head[lane] = (m_head[lane] + 1) & MASK;
+        } else {
+            for (; p < n - 1; ++p)
+                slot(lane, p) = at(lane, p + 1);
+        }
+        m_len[lane] = n - 1;
+    }
+
+    // Pool index `from` moved to `to` (swap-remove); y[from] is its height.
+    void rename(int lane, int from, int to, const float *y) {
+        int p = find(lane, from, y);
+        if (p >= 0)
+            slot(lane, p) = static_cast<std::int16_t>(to);
+    }
+
+    // First position in the lane whose y is below `bottom` (y < bottom).
+    int firstAbove(int lane, float bottom, const float *y) const {
+        int lo = 0, hi = m_len[lane];
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (y[at(lane, mid)] >= bottom) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    //
+    // Calls f(i) for every entity of lane whose y lies in [top, bottom), bottom
+    // to top. Stops early and returns true as soon as f returns true.
+    //
+    template <typename F>
+    bool query(int lane, float top, float bottom, const float *y, F f) const {
+        for (int p = firstAbove(lane, bottom, y); p < m_len[lane]; ++p) {
+            int i = at(lane, p);
+            if (y[i] < top)
+                break;
+            if (f(i))
+                return true;
+        }
+        return false;
+    }
+
+    // Writes every lane's entries to w, bottom to top (see EntityPool::save).
+    template <typename Writer>
+    void save(Writer &w) const {
+        for (int l = 0; l < MAX_LANES; ++l) {
+            int first = m_len[l] < Capacity - m_head[l] ? m_len[l] : Capacity - m_head[l];
+            w(m_len[l]);
+            w(&m_ring[l][m_head[l]], first);
+            w(&m_ring[l][0], m_len[l] - first);
+        }
+    }
+
+    // Reads back what save() wrote.
+    template <typename Reader>
+    void load(Reader &r) {
+        for (int l = 0; l < MAX_LANES; ++l) {
+            r(m_len[l]);
+            m_head[l] = 0;
+            r(m_ring[l], m_len[l]);
+        }
+    }
+
+private:
+    static const int MASK = Capacity - 1;
+
+    std::int16_t &slot(int lane, int k) { return m_ring[lane][(m_head[lane] + k) & MASK]; }
+
+    // Position of pool index i in its lane, or -1. Entries at the same height
+    // sit right before firstAbove(y[i]).
+    int find(int lane, int i, const float *y) const {
+        for (int p = firstAbove(lane, y[i], y) - 1; p >= 0 && y[at(lane, p)] == y[i]; --p)
+            if (at(lane, p) == i)
+                return p;
+        return -1;
+    }
+
+    std::int16_t m_ring[MAX_LANES][Capacity];
+    int m_head[MAX_LANES] = {};
+    int m_len[MAX_LANES] = {};
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+//
+// Lock-free hand-off between threads: exactly two for TripleBuffer and
+// SpscQueue, any number of producers for MpscQueue.
+//
+
+//
+// Triple buffer: the writer fills back() and publish()es it, the reader
+// picks up the newest published buffer with update() and reads front().
+// Neither side ever waits, and the reader never sees a buffer being written.
+//
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side.
+    T &back() { return m_buffers[m_back]; }
+    void publish() {
+        m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader side: takes the newest published buffer, if there is one. Returns
+    // whether front() changed.
+    bool update() {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T &front() const { return m_buffers[m_front]; }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;  // set on the middle index when it holds an unread buffer
+
+    T m_buffers[3];
+    int m_back = 0;   // writer only
+    int m_front = 1;  // reader only
+    std::atomic<int> m_middle{ 2 };
+};
+
+//
+// Bounded single-producer single-consumer ring. push() fails when full,
+// pop() when empty; Capacity must be a power of two.
+//
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+public:
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+    bool push(const T &value) {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        m_items[tail & (Capacity - 1)] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &value) {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        value = m_items[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Drops everything; only while neither side is using the queue.
+    void clear() { m_head.store(m_tail.load()); }
+
+private:
+    T m_items[Capacity];
+    alignas(64) std::atomic<std::size_t> m_head{ 0 };  // consumer
+    alignas(64) std::atomic<std::size_t> m_tail{ 0 };  // producer
+};
+
+//
+// Bounded multi-producer single-consumer ring (Vyukov's): every slot
+// carries a sequence number telling whose turn it is, so producers only
+// contend on the tail index and never wait for each other. push() fails
+// when full, pop() when empty; Capacity must be a power of two.
+//
+template <typename T, std::size_t Capacity>
+class MpscQueue {
+public:
+    static_assert((Capacity & (Capacity - 1)) == 0, "MpscQueue capacity must be a power of two");
+
+    MpscQueue() {
+        for (std::size_t i = 0; i < Capacity; ++i)
+            m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Any thread.
+    bool push(const T &value) {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = m_slots[tail & (Capacity - 1)];
+            std::size_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq == tail) {
+                if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.seq.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (seq < tail) {
+                return false;  // the consumer hasn't freed this slot yet: full
+            } else {
+                tail = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only.
+    bool pop(T &value) {
+        Slot &slot = m_slots[m_head & (Capacity - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != m_head + 1)
+            return false;
+        value = slot.value;
+        slot.seq.store(m_head + Capacity, std::memory_order_release);
+        ++m_head;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> seq;
+        T value;
+    };
+
+    Slot m_slots[Capacity];
+    alignas(64) std::atomic<std::size_t> m_tail{ 0 };  // producers
+    alignas(64) std::size_t m_head = 0;                // consumer
+};
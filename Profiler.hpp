@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//
+// Frame profiler. PROFILE_SCOPE(zone) times the rest of the enclosing block
+// into the current frame; counters are set once per frame. The last
+// HISTORY frames are kept for rolling percentiles, and with tracing on every
+// scope and counter is also recorded for a Chrome trace (chrome://tracing,
+// Perfetto). It has no SFML dependency so the simulation can use it too.
+// Scopes may close on any thread (the simulation has its own); they are
+// added to the frame that is open on the main thread and traced per thread.
+// When disabled a scope costs one branch.
+//
+
+enum ProfileZone {
+    ZONE_FRAME,
+    ZONE_EVENTS,
+    ZONE_SIM,
+    ZONE_SIM_SPEED,      // speed, stamina, scrolling, finish line, lane slide
+    ZONE_SIM_TREES,
+    ZONE_SIM_OBSTACLES,  // obstacle spawning, movement and collisions
+    ZONE_SIM_TRACK,      // track chunk generation
+    ZONE_SIM_BOTTLES,
+    ZONE_SIM_COINS,
+    ZONE_AUTOPILOT,      // Autopilot planning, on the simulation thread
+    ZONE_HISTORY,        // RaceHistory::record, on the simulation thread
+    ZONE_DRAW_TRACK,     // background, grass, road and finish line
+    ZONE_DRAW_ENTITIES,
+    ZONE_DRAW_HUD,
+    ZONE_SUBMIT,         // SpriteBatch::draw
+    ZONE_DISPLAY,
+    ZONE_PACE,           // FramePacer::wait
+    ZONE_COUNT
+};
+
+enum ProfileCounter { COUNTER_DRAW_CALLS, COUNTER_ENTITIES, COUNTER_ALLOCATIONS, COUNTER_COUNT };
+
+class Profiler {
+public:
+    static const int HISTORY = 240;  // frames kept for the percentiles
+
+    using Clock = std::chrono::steady_clock;
+
+    static Profiler &instance() {
+        static Profiler p;
+        return p;
+    }
+
+    static const char *zoneName(int z) {
+        static const char *names[ZONE_COUNT] = {
+            "frame", "events", "sim", "sim.speed", "sim.trees", "sim.obstacles", "sim.track",
+            "sim.bottles", "sim.coins", "sim.autopilot", "sim.history", "draw.track", "draw.entities", "draw.hud", "submit",
+            "display", "pace"
+        };
+        return names[z];
+    }
+
+    static const char *counterName(int c) {
+        static const char *names[COUNTER_COUNT] = { "draw calls", "entities", "allocations" };
+        return names[c];
+    }
+
+    std::atomic<bool> enabled{ false };
+
+    // Starts recording every scope for writeTrace(); at most maxEvents are kept.
+    void startTrace(size_t maxEvents = 1 << 21) {
+        m_trace.clear();
+        m_trace.reserve(maxEvents);
+        m_traceLimit = maxEvents;
+        m_tracing = true;
+        enabled = true;
+    }
+
+    bool tracing() const { return m_tracing; }
+
+    void beginFrame() {
+        if (!enabled)
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::fill(m_current, m_current + ZONE_COUNT, 0.0);
+        m_frameStart = Clock::now();
+        m_inFrame = true;
+    }
+
+    // Closes the frame opened by beginFrame(); does nothing if there is none.
+    void endFrame() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_inFrame)
+            return;
+        m_inFrame = false;
+        addLocked(ZONE_FRAME, m_frameStart, Clock::now());
+        for (int z = 0; z < ZONE_COUNT; ++z)
+            m_history[z][m_frame % HISTORY] = static_cast<float>(m_current[z]);
+        for (int c = 0; c < COUNTER_COUNT; ++c) {
+            m_lastCounters[c] = m_counters[c];
+            if (m_tracing && m_trace.size() < m_traceLimit)
+                m_trace.push_back(Event{ -1 - c, threadId(), micros(Clock::now()), m_counters[c] });
+        }
+        ++m_frame;
+    }
+
+    void setCounter(ProfileCounter c, std::int64_t v) { m_counters[c] = v; }
+
+    // Adds a finished scope to the current frame (and the trace).
+    void add(ProfileZone z, Clock::time_point start, Clock::time_point end) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        addLocked(z, start, end);
+    }
+
+    // p in [0, 1] over the recorded history of zone z, in milliseconds.
+    float percentile(ProfileZone z, float p) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int n = static_cast<int>(std::min<std::uint64_t>(m_frame, HISTORY));
+        if (n == 0)
+            return 0.f;
+        float sorted[HISTORY];
+        std::copy(m_history[z], m_history[z] + n, sorted);
+        int k = std::min(n - 1, static_cast<int>(p * (n - 1) + 0.5f));
+        std::nth_element(sorted, sorted + k, sorted + n);
+        return sorted[k];
+    }
+
+    // Last completed frame's time in zone z (ms) / counter value.
+    float last(ProfileZone z) const { return m_frame ? m_history[z][(m_frame - 1) % HISTORY] : 0.f; }
+    std::int64_t counter(ProfileCounter c) const { return m_lastCounters[c]; }
+
+    // Writes the trace in Chrome's JSON trace event format.
+    bool writeTrace(const std::string &path) const {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        out << "{\"traceEvents\":[\n";
+        for (size_t i = 0; i < m_trace.size(); ++i) {
+            const Event &e = m_trace[i];
+            if (e.id >= 0)
+                out << "{\"name\":\"" << zoneName(e.id) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid << ",\"ts\":"
+                    << e.ts << ",\"dur\":" << e.value << "}";
+            else
+                out << "{\"name\":\"" << counterName(-1 - e.id) << "\",\"ph\":\"C\",\"pid\":1,\"ts\":"
+                    << e.ts << ",\"args\":{\"value\":" << e.value << "}}";
+            out << (i + 1 < m_trace.size() ? ",\n" : "\n");
+        }
+        out << "]}\n";
+        return static_cast<bool>(out);
+    }
+
+private:
+    // A zone scope (id >= 0, value = duration in us) or a counter sample (id = -1 - counter).
+    struct Event {
+        int id;
+        int tid;
+        std::int64_t ts;
+        std::int64_t value;
+    };
+
+    Profiler() : m_epoch(Clock::now()) {}
+
+    void addLocked(ProfileZone z, Clock::time_point start, Clock::time_point end) {
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        m_current[z] += ms;
+        if (m_tracing && m_trace.size() < m_traceLimit)
+            m_trace.push_back(Event{ z, threadId(), micros(start), static_cast<std::int64_t>(ms * 1000.0) });
+    }
+
+    // Small per-thread number for the trace, 1 for the first thread that records.
+    static int threadId() {
+        static std::atomic<int> next{ 1 };
+        thread_local int id = next++;
+        return id;
+    }
+
+    std::int64_t micros(Clock::time_point t) const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(t - m_epoch).count();
+    }
+
+    Clock::time_point m_epoch, m_frameStart;
+    double m_current[ZONE_COUNT] = {};
+    float m_history[ZONE_COUNT][HISTORY] = {};
+    std::int64_t m_counters[COUNTER_COUNT] = {};
+    std::int64_t m_lastCounters[COUNTER_COUNT] = {};
+    std::uint64_t m_frame = 0;
+    bool m_inFrame = false;
+    bool m_tracing = false;
+    size_t m_traceLimit = 0;
+    std::vector<Event> m_trace;
+    mutable std::mutex m_mutex;
+};
+
+// Times the enclosing scope into a zone of the global profiler.
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileZone zone) : m_zone(zone), m_on(Profiler::instance().enabled) {
+        if (m_on)
+            m_start = Profiler::Clock::now();
+    }
+    ~ProfileScope() { stop(); }
+
+    // Ends the scope before the end of the block.
+    void stop() {
+        if (m_on)
+            Profiler::instance().add(m_zone, m_start, Profiler::Clock::now());
+        m_on = false;
+    }
+
+private:
+    ProfileZone m_zone;
+    bool m_on;
+    Profiler::Clock::time_point m_start;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(zone) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(zone)
+
+//
+// Number of heap allocations made so far. main.cpp counts them by replacing
+// the global operator new; elsewhere this stays at zero.
+//
+inline std::atomic<std::uint64_t> &allocationCount() {
+    static std::atomic<std::uint64_t> count{ 0 };
+    return count;
+}
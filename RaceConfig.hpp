@@ -0,0 +1,64 @@
+#pragma once
+
+// Unscaled texture size in pixels.
+struct SpriteSize {
+    float w = 0.f, h = 0.f;
+};
+
+//
+// Everything the simulation needs to know about the world: view and texture
+// geometry (filled in from the loaded textures) and the gameplay tuning values.
+//
+struct RaceConfig {
+    static const int TREE_KINDS = 5;
+    static const int OBSTACLE_KINDS = 5;
+
+    // — VIEW & TEXTURE GEOMETRY —
+    float viewWidth = 800.f, viewHeight = 600.f;
+    SpriteSize road, grass, finishLine, player, bottle, coin;
+    SpriteSize trees[TREE_KINDS];
+    SpriteSize obstacles[OBSTACLE_KINDS];
+
+    // — SPRITE SCALES —
+    float playerScale = 0.25f;
+    float obstacleScale = 0.20f;
+    float bottleScale = 0.23f;
+    float coinScale = 0.16f;
+
+    // — RACE LENGTH —
+    int numTiles = 10;
+    float finishSpawnBefore = 500.f;  // finish line appears this far before the end
+    float finishDelay = 2.0f;         // seconds between crossing the line and FINISH
+    float hitDuration = 2.f;          // seconds of blinking after a crash
+
+    // — STAMINA & COLLECTIBLE PARAMETERS —
+    float maxStamina = 5.f;
+    float staminaDrain = 3.f;
+    float staminaRegen = 0.5f;
+    float bottleStamina = 1.f;
+    float minStaminaToBoost = 0.5f;
+
+    // — MOVEMENT & SPEED PARAMETERS (pixels per second) —
+    float defaultSpeed = 240.f, maxSpeed = 720.f;
+    float accel = 720.f, brakeForce = 1800.f;  // pixels per second, per second
+    float obstacleSpeed = 240.f;
+    float laneSlide = 300.f;
+
+    // — LANE & ROAD GEOMETRY —
+    float padLeft = 0.15f, padRight = 0.15f;
+    int lanes = 4;
+    int startLane = 1;
+    int startLives = 3;
+
+    // — SPAWN RATES (items per second at defaultSpeed; TrackStream turns them into spacing) —
+    float treeRate = 1.2f;
+    float obstacleRate = 6.f;
+    float bottleRate = 0.3f;
+    float coinRate = 0.24f;
+    // Scales the minimum gaps between items of a kind and between obstacle
+    // rows; 0 leaves only the rates (and the chunk capacity) to space them.
+    // Only stress scenarios change it.
+    float minGapScale = 1.f;
+
+    float raceDistance() const { return road.h * numTiles; }
+};
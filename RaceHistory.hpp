@@ -0,0 +1,411 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "Profiler.hpp"
+#include "RaceSimulation.hpp"
+#include "RaceSnapshot.hpp"
+
+//
+// Byte sinks and sources for RaceSimulation::saveState / loadState and the
+// history records: io(value) or io(array, count), a memcpy each.
+//
+struct StateWriter {
+    std::uint8_t *out;
+
+    template <typename T>
+    void operator()(const T *data, int n) {
+        static_assert(std::is_trivially_copyable<T>::value, "history fields are copied as raw bytes");
+        std::memcpy(out, data, sizeof(T) * n);
+        out += sizeof(T) * n;
+    }
+    template <typename T>
+    void operator()(const T &v) { (*this)(&v, 1); }
+};
+
+// Counts what a StateWriter would write.
+struct StateSizer {
+    std::size_t bytes = 0;
+
+    template <typename T>
+    void operator()(const T *, int n) { bytes += sizeof(T) * n; }
+    template <typename T>
+    void operator()(const T &) { bytes += sizeof(T); }
+};
+
+struct StateReader {
+    const std::uint8_t *in;
+
+    template <typename T>
+    void operator()(T *data, int n) {
+        std::memcpy(data, in, sizeof(T) * n);
+        in += sizeof(T) * n;
+    }
+    template <typename T>
+    void operator()(T &v) { (*this)(&v, 1); }
+};
+
+//
+// What the renderer needs of one step besides the entity positions.
+//
+struct HistoryFrame {
+    GameState state = GAME;
+    bool finishLineSpawned = false;
+    int lives = 0, score = 0;
+    float stamina = 0.f, hitTime = 0.f, distanceTraveled = 0.f, trackPos = 0.f;
+    float playerX = 0.f, prevPlayerX = 0.f, playerY = 0.f;
+    float roadLeft = 0.f;
+    float finishX = 0.f, finishY = 0.f, finishScale = 1.f;
+    float lastScroll = 0.f;
+
+    static HistoryFrame of(const RaceSimulation &sim) {
+        HistoryFrame f;
+        f.state = sim.state;
+        f.finishLineSpawned = sim.finishLineSpawned;
+        f.lives = sim.lives;
+        f.score = sim.score;
+        f.stamina = sim.stamina;
+        f.hitTime = sim.hitTime;
+        f.distanceTraveled = sim.distanceTraveled;
+        f.trackPos = sim.trackPos;
+        f.playerX = sim.playerX;
+        f.prevPlayerX = sim.prevPlayerX;
+        f.playerY = sim.playerY;
+        f.roadLeft = sim.roadLeft();
+        f.finishX = sim.finishX;
+        f.finishY = sim.finishY;
+        f.finishScale = sim.finishScale();
+        f.lastScroll = sim.lastScroll;
+        return f;
+    }
+
+    void applyTo(RaceSnapshot &s) const {
+        s.state = state;
+        s.finishLineSpawned = finishLineSpawned;
+        s.lives = lives;
+        s.score = score;
+        s.stamina = stamina;
+        s.hitTime = hitTime;
+        s.distanceTraveled = distanceTraveled;
+        s.trackPos = trackPos;
+        s.playerX = playerX;
+        s.prevPlayerX = prevPlayerX;
+        s.playerY = playerY;
+        s.roadLeft = roadLeft;
+        s.finishX = finishX;
+        s.finishY = finishY;
+        s.finishScale = finishScale;
+        s.lastScroll = lastScroll;
+    }
+};
+
+//
+// The last seconds of a race, one record per simulation step in a fixed
+// ring of bytes allocated once: the kill-cam plays them back after a crash
+// and the dev rewind key jumps back into them.
+//
+// Every KEYFRAME_STEPS steps (and whenever the view changes size) a record
+// is a keyframe: the drawable frame plus the whole race as saveState()
+// writes it, which is what rewind() copies back. The steps in between only
+// hold the drawable frame as a delta: entities are in world space, where
+// only the obstacles move, all by the same amount, so a pool that nothing
+// entered or left is stored as nothing (the obstacles as the distance they
+// moved) and only a pool that changed is stored whole. Ten seconds of a
+// normal race take about 120 KB; the oldest records are overwritten as new
+// ones come in.
+//
+// record() runs on the simulation thread; everything else only while it is
+// paused.
+//
+class RaceHistory {
+public:
+    static const int STEPS = 1280;          // records indexed, a bit over 10 s at 120 Hz
+    static const int KEYFRAME_STEPS = 60;   // a keyframe every 0.5 s
+    static const std::size_t BYTES = 512 * 1024;  // a normal race needs about 120 KB for STEPS
+
+    explicit RaceHistory(std::size_t bytes = BYTES) : m_bytes(bytes) { clear(); }
+
+    // Forgets everything; the next record is a keyframe.
+    void clear() {
+        m_oldest = 0;
+        m_newest = -1;
+        m_lastKey = -1;
+        m_writePos = 0;
+    }
+
+    // Records the step sim just made.
+    void record(const RaceSimulation &sim) {
+        PROFILE_SCOPE(ZONE_HISTORY);
+        int step = m_newest + 1;
+        std::uint8_t changed = 0;
+        if (m_lastKey < 0 || step - m_lastKey >= KEYFRAME_STEPS ||
+            sim.cfg.viewWidth != m_viewWidth || sim.cfg.viewHeight != m_viewHeight) {
+            changed = KEYFRAME;
+        } else {
+            std::uint32_t versions[POOLS] = { sim.trees.version(), sim.obstacles.version(),
+                                              sim.bottles.version(), sim.coins.version() };
+            for (int p = 0; p < POOLS; ++p)
+                if (versions[p] != m_versions[p])
+                    changed |= 1 << p;
+        }
+
+        StateSizer size;
+        write(size, sim, changed);
+        if (size.bytes > m_bytes.size()) {  // can't be kept at all; start over
+            clear();
+            return;
+        }
+        std::size_t at = m_writePos + size.bytes > m_bytes.size() ? 0 : m_writePos;
+
+        // Make room. On a wrap the records past the write position (the tail
+        // of the previous pass) are the oldest and go first; then the oldest
+        // records the new one overwrites.
+        if (at == 0)
+            while (m_oldest <= m_newest && m_records[m_oldest % STEPS].offset >= m_writePos)
+                ++m_oldest;
+        while (m_oldest <= m_newest) {
+            const Record &old = m_records[m_oldest % STEPS];
+            bool overlaps = old.offset < at + size.bytes && at < old.offset + old.size;
+            if (!overlaps && step - m_oldest < STEPS)
+                break;
+            ++m_oldest;
+        }
+
+        StateWriter w{ &m_bytes[at] };
+        write(w, sim, changed);
+        Record &rec = m_records[step % STEPS];
+        rec.offset = at;
+        rec.size = size.bytes;
+        rec.events = sim.events;
+        rec.key = (changed & KEYFRAME) ? step : m_lastKey;
+        m_writePos = at + size.bytes;
+        m_newest = step;
+        if (changed & KEYFRAME) {
+            m_lastKey = step;
+            m_viewWidth = sim.cfg.viewWidth;
+            m_viewHeight = sim.cfg.viewHeight;
+        }
+        noteVersions(sim);
+    }
+
+    // Steps that can be played back, oldest to newest (empty if newest < oldest).
+    int oldestStep() const { return firstKeyAtOrAfter(m_oldest); }
+    int newestStep() const { return m_newest; }
+    static float secondsOf(int steps) { return steps * RaceSimulation::STEP_DT; }
+    static int stepsOf(float seconds) { return static_cast<int>(seconds / RaceSimulation::STEP_DT + 0.5f); }
+
+    // Newest step that raised any of `events` (EVENT_* bits), or -1.
+    int lastStepWith(unsigned events) const {
+        for (int s = m_newest, first = oldestStep(); s >= first; --s)
+            if (m_records[s % STEPS].events & events)
+                return s;
+        return -1;
+    }
+
+    //
+    // Makes `out` show `step`. If out showed `from` (an earlier step, as
+    // left by a previous call) the deltas in between are applied; otherwise
+    // decoding starts at the keyframe before step. Returns false if step is
+    // no longer (or not yet) in the history.
+    //
+    bool decode(int step, RaceSnapshot &out, int from = -1) const {
+        if (step < oldestStep() || step > m_newest)
+            return false;
+        int key = m_records[step % STEPS].key;
+        int s = from >= key && from < step ? from + 1 : key;
+        for (; s <= step; ++s)
+            read(m_records[s % STEPS], out);
+        return true;
+    }
+
+    //
+    // Puts sim back to the newest keyframe at least `steps` before the newest
+    // step (or the oldest one there is) and drops everything after it.
+    // Returns the step it went back to, or -1 if there is no history.
+    //
+    int rewind(RaceSimulation &sim, int steps) {
+        int first = oldestStep();
+        if (first > m_newest)
+            return -1;
+        int target = m_newest - steps < first ? first : m_newest - steps;
+        int key = m_records[target % STEPS].key;
+        if (key < first)
+            key = first;
+        const Record &rec = m_records[key % STEPS];
+        StateReader r{ &m_bytes[rec.offset] };
+        skipFrame(r);
+        sim.loadState(r);
+        m_newest = key;
+        m_lastKey = key;
+        m_writePos = rec.offset + rec.size;
+        noteVersions(sim);
+        return key;
+    }
+
+private:
+    enum { POOLS = 4, KEYFRAME = 0x80 };
+
+    struct Record {
+        std::size_t offset = 0, size = 0;
+        unsigned events = EVENT_NONE;
+        int key = -1;  // the keyframe this step decodes from
+    };
+
+    //
+    // Record layout: u8 changed pools (bit per pool, KEYFRAME for a keyframe)
+    // | HistoryFrame | per changed pool: count, x, y, prevY, kind | obstacles
+    // not changed: the distance they moved | keyframes: RaceSimulation::saveState.
+    //
+    template <typename Writer>
+    static void write(Writer &w, const RaceSimulation &sim, std::uint8_t changed) {
+        w(changed);
+        w(HistoryFrame::of(sim));
+        writePool(w, sim.trees, changed & (KEYFRAME | 1));
+        writePool(w, sim.obstacles, changed & (KEYFRAME | 2));
+        writePool(w, sim.bottles, changed & (KEYFRAME | 4));
+        writePool(w, sim.coins, changed & (KEYFRAME | 8));
+        if (!(changed & (KEYFRAME | 2)))
+            w(sim.lastObstacleMove);
+        if (changed & KEYFRAME)
+            sim.saveState(w);
+    }
+
+    template <typename Writer, int N>
+    static void writePool(Writer &w, const EntityPool<N> &pool, bool whole) {
+        if (!whole)
+            return;
+        int n = pool.size();
+        w(n);
+        w(pool.x, n);
+        w(pool.y, n);
+        w(pool.prevY, n);
+        w(pool.kind, n);
+    }
+
+    void read(const Record &rec, RaceSnapshot &out) const {
+        StateReader r{ &m_bytes[rec.offset] };
+        std::uint8_t changed;
+        r(changed);
+        HistoryFrame frame;
+        r(frame);
+        frame.applyTo(out);
+        readPool(r, out.trees, changed & (KEYFRAME | 1));
+        readPool(r, out.obstacles, changed & (KEYFRAME | 2));
+        readPool(r, out.bottles, changed & (KEYFRAME | 4));
+        readPool(r, out.coins, changed & (KEYFRAME | 8));
+        if (!(changed & (KEYFRAME | 2))) {
+            float moved;
+            r(moved);
+            for (int i = 0; i < out.obstacles.count; ++i) {
+                out.obstacles.prevY[i] = out.obstacles.y[i];
+                out.obstacles.y[i] += moved;
+            }
+        }
+        if (changed & KEYFRAME)
+            r(out.cfg);  // saveState starts with the config
+        out.replayEnded = false;
+    }
+
+    template <int N>
+    static void readPool(StateReader &r, PoolSnapshot<N> &pool, bool whole) {
+        if (!whole)
+            return;
+        r(pool.count);
+        r(pool.x, pool.count);
+        r(pool.y, pool.count);
+        r(pool.prevY, pool.count);
+        r(pool.kind, pool.count);
+    }
+
+    // Moves r past a keyframe's drawable part, to its saveState.
+    static void skipFrame(StateReader &r) {
+        std::uint8_t changed;
+        r(changed);
+        r.in += sizeof(HistoryFrame);
+        for (int p = 0; p < POOLS; ++p) {
+            int n;
+            r(n);
+            r.in += n * (3 * sizeof(float) + sizeof(std::uint8_t));
+        }
+    }
+
+    int firstKeyAtOrAfter(int step) const {
+        for (; step <= m_newest; ++step)
+            if (m_records[step % STEPS].key == step)
+                return step;
+        return m_newest + 1;
+    }
+
+    void noteVersions(const RaceSimulation &sim) {
+        m_versions[0] = sim.trees.version();
+        m_versions[1] = sim.obstacles.version();
+        m_versions[2] = sim.bottles.version();
+        m_versions[3] = sim.coins.version();
+    }
+
+    std::vector<std::uint8_t> m_bytes;
+    Record m_records[STEPS];
+    int m_oldest = 0, m_newest = -1;  // steps still recorded
+    int m_lastKey = -1;
+    std::size_t m_writePos = 0;
+    std::uint32_t m_versions[POOLS] = {};
+    float m_viewWidth = 0.f, m_viewHeight = 0.f;
+};
+
+//
+// Plays a stretch of a RaceHistory back for drawing, at `speed` times real
+// time: the kill-cam. The frame is decoded forward a step at a time.
+//
+class HistoryPlayback {
+public:
+    HistoryPlayback() : m_frame(new RaceSnapshot) {}
+
+    // Plays steps [from, to]; false if there is nothing to play.
+    bool start(const RaceHistory &history, int from, int to, float speed) {
+        m_history = &history;
+        from = from < history.oldestStep() ? history.oldestStep() : from;
+        to = to > history.newestStep() ? history.newestStep() : to;
+        if (from > to || !history.decode(from, *m_frame)) {
+            m_history = nullptr;
+            return false;
+        }
+        m_step = from;
+        m_to = to;
+        m_speed = speed;
+        m_time = 0.f;
+        return true;
+    }
+
+    void stop() { m_history = nullptr; }
+    bool active() const { return m_history != nullptr; }
+
+    // Advances by dt seconds of wall time; false once the end was reached.
+    bool advance(float dt) {
+        if (!m_history)
+            return false;
+        m_time += dt * m_speed;
+        int target = m_step + static_cast<int>(m_time / RaceSimulation::STEP_DT);
+        if (target > m_to)
+            return false;
+        if (target > m_step) {
+            m_history->decode(target, *m_frame, m_step);
+            m_time -= (target - m_step) * RaceSimulation::STEP_DT;
+            m_step = target;
+        }
+        return true;
+    }
+
+    const RaceSnapshot &frame() const { return *m_frame; }
+    float alpha() const { return m_time / RaceSimulation::STEP_DT; }
+
+private:
+    const RaceHistory *m_history = nullptr;
+    std::unique_ptr<RaceSnapshot> m_frame;
+    int m_step = 0, m_to = 0;
+    float m_speed = 1.f, m_time = 0.f;
+};
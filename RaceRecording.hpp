@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "RaceSimulation.hpp"
+
+//
+// Input recording of one race: the seed, the RaceConfig the race started
+// with, and every step's input, run-length encoded (one input byte followed
+// by a varint repeat count). View resizes are stored in the same stream, at
+// the step they happened, so replays see exactly the same geometry.
+//
+// File layout (native endianness):
+//   "BKRP" | u32 version | u32 sizeof(RaceConfig) | u64 seed | RaceConfig
+//   | u32 step count | u32 stream size | stream bytes
+//
+struct RaceRecording {
+    static constexpr std::uint32_t VERSION = 4;  // 2: courses come from TrackStream, 3: pixel-exact crashes, 4: world space
+    static constexpr std::uint8_t RESIZE = 0xFF;  // followed by u16 width, u16 height
+
+    std::uint64_t seed = 0;
+    RaceConfig config;
+    std::uint32_t steps = 0;
+    std::vector<std::uint8_t> stream;
+
+    static_assert(std::is_trivially_copyable<RaceConfig>::value, "RaceConfig is written as raw bytes");
+
+    // Starts a new recording for a race that was just reset.
+    void begin(const RaceSimulation &sim) {
+        seed = sim.seed;
+        config = sim.cfg;
+        steps = 0;
+        stream.clear();
+        m_runByte = 0;
+        m_runLength = 0;
+    }
+
+    void recordStep(const RaceInput &in) {
+        std::uint8_t b = encode(in);
+        if (m_runLength > 0 && b != m_runByte)
+            flushRun();
+        m_runByte = b;
+        ++m_runLength;
+        ++steps;
+    }
+
+    void recordResize(float w, float h) {
+        flushRun();
+        stream.push_back(RESIZE);
+        putU16(static_cast<std::uint16_t>(w));
+        putU16(static_cast<std::uint16_t>(h));
+    }
+
+    bool save(const std::string &path) {
+        flushRun();
+        std::ofstream out(path, std::ios::binary);
+        if (!out)
+            return false;
+        std::uint32_t cfgSize = sizeof(RaceConfig);
+        std::uint32_t streamSize = static_cast<std::uint32_t>(stream.size());
+        out.write("BKRP", 4);
+        out.write(reinterpret_cast<const char *>(&VERSION), sizeof VERSION);
+        out.write(reinterpret_cast<const char *>(&cfgSize), sizeof cfgSize);
+        out.write(reinterpret_cast<const char *>(&seed), sizeof seed);
+        out.write(reinterpret_cast<const char *>(&config), sizeof config);
+        out.write(reinterpret_cast<const char *>(&steps), sizeof steps);
+        out.write(reinterpret_cast<const char *>(&streamSize), sizeof streamSize);
+        out.write(reinterpret_cast<const char *>(stream.data()), streamSize);
+        return static_cast<bool>(out);
+    }
+
+    bool load(const std::string &path) {
+        std::ifstream in(path, std::ios::binary);
+        char magic[4];
+        std::uint32_t version = 0, cfgSize = 0, streamSize = 0;
+        if (!in.read(magic, 4) || std::memcmp(magic, "BKRP", 4) != 0)
+            return false;
+        in.read(reinterpret_cast<char *>(&version), sizeof version);
+        in.read(reinterpret_cast<char *>(&cfgSize), sizeof cfgSize);
+        if (!in || version != VERSION || cfgSize != sizeof(RaceConfig))
+            return false;
+        in.read(reinterpret_cast<char *>(&seed), sizeof seed);
+        in.read(reinterpret_cast<char *>(&config), sizeof config);
+        in.read(reinterpret_cast<char *>(&steps), sizeof steps);
+        in.read(reinterpret_cast<char *>(&streamSize), sizeof streamSize);
+        if (!in)
+            return false;
+        stream.resize(streamSize);
+        in.read(reinterpret_cast<char *>(stream.data()), streamSize);
+        m_runLength = 0;
+        return static_cast<bool>(in);
+    }
+
+    // Step input <-> byte: bits 0-2 lane change + 4, bit 3 boost, bit 4 brake.
+    static std::uint8_t encode(const RaceInput &in) {
+        int lc = in.laneChange < -3 ? -3 : (in.laneChange > 3 ? 3 : in.laneChange);
+        return static_cast<std::uint8_t>((lc + 4) | (in.boost ? 8 : 0) | (in.brake ? 16 : 0));
+    }
+    static RaceInput decode(std::uint8_t b) {
+        RaceInput in;
+        in.laneChange = (b & 7) - 4;
+        in.boost = (b & 8) != 0;
+        in.brake = (b & 16) != 0;
+        return in;
+    }
+
+private:
+    void flushRun() {
+        if (m_runLength == 0)
+            return;
+        stream.push_back(m_runByte);
+        for (std::uint32_t n = m_runLength; ; n >>= 7) {
+            if (n < 0x80) { stream.push_back(static_cast<std::uint8_t>(n)); break; }
+            stream.push_back(static_cast<std::uint8_t>((n & 0x7F) | 0x80));
+        }
+        m_runLength = 0;
+    }
+
+    void putU16(std::uint16_t v) {
+        stream.push_back(static_cast<std::uint8_t>(v & 0xFF));
+        stream.push_back(static_cast<std::uint8_t>(v >> 8));
+    }
+
+    std::uint8_t m_runByte = 0;
+    std::uint32_t m_runLength = 0;
+};
+
+//
+// Plays a RaceRecording back one step at a time.
+//
+class RaceReplay {
+public:
+    explicit RaceReplay(const RaceRecording &rec) : m_rec(&rec) {}
+
+    // Starts the recorded race on sim.
+    void start(RaceSimulation &sim) {
+        sim.cfg = m_rec->config;  // keeps the simulation's collision masks and telemetry
+        sim.reset(m_rec->seed);
+        m_pos = 0;
+        m_left = 0;
+    }
+
+    //
+    // Applies any view resize recorded before the next step to sim and
+    // returns that step's input in `in`. Returns false once the recording
+    // is exhausted.
+    //
+    bool next(RaceSimulation &sim, RaceInput &in) {
+        const std::vector<std::uint8_t> &s = m_rec->stream;
+        while (m_left == 0) {
+            if (m_pos >= s.size())
+                return false;
+            std::uint8_t b = s[m_pos++];
+            if (b == RaceRecording::RESIZE) {
+                if (m_pos + 4 > s.size())
+                    return false;
+                float w = static_cast<float>(s[m_pos] | (s[m_pos + 1] << 8));
+                float h = static_cast<float>(s[m_pos + 2] | (s[m_pos + 3] << 8));
+                m_pos += 4;
+                sim.resize(w, h);
+                continue;
+            }
+            m_byte = b;
+            std::uint32_t n = 0;
+            for (int shift = 0; m_pos < s.size(); shift += 7) {
+                std::uint8_t v = s[m_pos++];
+                n |= static_cast<std::uint32_t>(v & 0x7F) << shift;
+                if (!(v & 0x80))
+                    break;
+            }
+            m_left = n;
+        }
+        --m_left;
+        in = RaceRecording::decode(m_byte);
+        return true;
+    }
+
+private:
+    const RaceRecording *m_rec;
+    size_t m_pos = 0;
+    std::uint32_t m_left = 0;
+    std::uint8_t m_byte = 0;
+};
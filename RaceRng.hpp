@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+//
+// Small seedable PRNG (PCG32) owned by each race, so the same seed always
+// spawns the same trees, obstacles and collectibles on every machine,
+// independent of std::rand() and of any other race running at the same time.
+//
+struct RaceRng {
+    std::uint64_t state = 0x853c49e6748fea9bULL;
+    std::uint64_t inc = 0xda3e39cb94b95bdbULL;
+
+    RaceRng() = default;
+    explicit RaceRng(std::uint64_t seed) { reseed(seed); }
+
+    void reseed(std::uint64_t seed, std::uint64_t stream = 54u) {
+        state = 0u;
+        inc = (stream << 1u) | 1u;
+        next();
+        state += seed;
+        next();
+    }
+
+    std::uint32_t next() {
+        std::uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        std::uint32_t xorshifted = static_cast<std::uint32_t>(((old >> 18u) ^ old) >> 27u);
+        std::uint32_t rot = static_cast<std::uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+
+    // Uniform integer in [0, n); n must be > 0.
+    int below(int n) { return static_cast<int>(next() % static_cast<std::uint32_t>(n)); }
+
+    // Uniform float in [0, 1).
+    float uniform() { return (next() >> 8) * (1.f / 16777216.f); }
+};
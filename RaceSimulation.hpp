@@ -0,0 +1,597 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "CollisionMask.hpp"
+#include "EntityPool.hpp"
+#include "Profiler.hpp"
+#include "RaceConfig.hpp"
+#include "Telemetry.hpp"
+#include "TrackStream.hpp"
+
+//
+// Headless race simulation: everything that happens during GAME / HIT / FINISH
+// (lanes, spawning, movement, stamina, collisions, finish line) without any
+// SFML window or audio dependency. main() advances it in fixed STEP_DT steps
+// and the renderer reads the public state below, interpolating positions
+// between the previous and the current step.
+//
+
+// Game states
+enum GameState { MENU, APROPOS, LOADING, GAME, HIT, FINISH };
+
+// Axis-aligned box, same semantics as sf::FloatRect::intersects.
+struct SimRect {
+    float left = 0.f, top = 0.f, width = 0.f, height = 0.f;
+
+    bool intersects(const SimRect &o) const {
+        float l = std::max(std::min(left, left + width), std::min(o.left, o.left + o.width));
+        float t = std::max(std::min(top, top + height), std::min(o.top, o.top + o.height));
+        float r = std::min(std::max(left, left + width), std::max(o.left, o.left + o.width));
+        float b = std::min(std::max(top, top + height), std::max(o.top, o.top + o.height));
+        return l < r && t < b;
+    }
+};
+
+// Input sampled for one step.
+struct RaceInput {
+    int laneChange = 0;  // -1 left, +1 right, 0 none
+    bool boost = false;
+    bool brake = false;
+};
+
+// Things that happened during a step, for sounds and effects.
+enum RaceEvent : unsigned {
+    EVENT_NONE   = 0,
+    EVENT_CRASH  = 1u << 0,
+    EVENT_DRINK  = 1u << 1,
+    EVENT_COIN   = 1u << 2,
+    EVENT_TIRED  = 1u << 3,
+    EVENT_FINISH = 1u << 4,
+};
+
+// Linear blend between the previous and the current step.
+inline float lerpStep(float prev, float cur, float alpha) {
+    return prev + (cur - prev) * alpha;
+}
+
+struct RaceSimulation {
+    static constexpr float STEP_DT = 1.f / 120.f;  // fixed simulation step (120 Hz)
+
+    RaceConfig cfg;
+
+    GameState state = GAME;
+    unsigned events = EVENT_NONE;  // events raised by the last step()
+    std::uint64_t seed = 0;        // seed of the current race
+    TrackStream track;             // the course, generated from the seed ahead of the player
+
+    // — PLAYER —
+    int playerLane = 1;
+    float playerX = 0.f, playerY = 0.f;
+    float prevPlayerX = 0.f;
+    int lives = 3, score = 0;
+    int coinsCollected = 0, bottlesCollected = 0;
+    float stamina = 5.f;
+    float playerWorldSpeed = 4.f;
+    bool boosting = false;
+    bool braking = false;
+    bool triedWhileExhausted = false;
+    float hitTime = 0.f;  // seconds since the last crash while in HIT
+
+    // — TRACK —
+    float distanceTraveled = 0.f;
+    float trackPos = 0.f;    // how far the view has scrolled since the start (keeps going past the finish)
+    float lastScroll = 0.f;  // how far the view moved during the last step
+    float lastObstacleMove = 0.f;  // how far the obstacles moved (in world space) during the last step
+    bool finishLineSpawned = false;
+    bool finishTriggered = false;
+    bool raceFinished = false;
+    float finishTime = 0.f;  // seconds since the finish line was crossed
+    float finishX = 0.f, finishY = 0.f;
+    float lastRowAt = -1.f;  // track position of the last obstacle row let in
+
+    // — ENTITIES (fixed capacity, allocated with the simulation) —
+    // Entity and finish line positions are in world space (see viewTop()).
+    static const int MAX_TREES = 1024;
+    static const int MAX_OBSTACLES = 1024;
+    static const int MAX_BOTTLES = 512;
+    static const int MAX_COINS = 1024;
+    EntityPool<MAX_TREES> trees;
+    EntityPool<MAX_OBSTACLES> obstacles;
+    EntityPool<MAX_BOTTLES> bottles;
+    EntityPool<MAX_COINS> coins;
+
+    // Optional, shared and read-only; with every mask present, crashes need
+    // opaque player and obstacle pixels to touch instead of half-width boxes.
+    const CollisionMasks *masks = nullptr;
+
+    // Optional; spawns, pickups, crashes and lane changes are logged to it.
+    Telemetry *telemetry = nullptr;
+
+    RaceSimulation() = default;
+    explicit RaceSimulation(const RaceConfig &config) : cfg(config) { reset(); }
+
+    // — GEOMETRY HELPERS —
+    float roadLeft() const { return (cfg.viewWidth - cfg.road.w) / 2.f; }
+    float laneWidth() const {
+        return (cfg.road.w - (cfg.padLeft + cfg.padRight) * cfg.road.w) / cfg.lanes;
+    }
+    float laneCenter(int lane) const {
+        return roadLeft() + cfg.padLeft * cfg.road.w + laneWidth() * (lane + 0.5f);
+    }
+    // Lane under view x (clamped to the road's lanes).
+    int laneAtX(float x) const {
+        float lw = laneWidth();
+        int l = lw > 0.f ? static_cast<int>(std::floor((x - roadLeft() - cfg.padLeft * cfg.road.w) / lw)) : 0;
+        return std::max(0, std::min(cfg.lanes - 1, l));
+    }
+    // Lanes whose entities (up to halfW wide on each side of the lane centre)
+    // can touch the horizontal span [left, right).
+    void laneSpan(float left, float right, float halfW, int &first, int &last) const {
+        first = laneAtX(left - halfW);
+        last = laneAtX(right + halfW);
+    }
+    float finishScale() const {
+        return cfg.finishLine.w > 0.f ? cfg.road.w / cfg.finishLine.w : 1.f;
+    }
+
+    //
+    // World space: y only changes when something moves on its own (the
+    // obstacles); trees, collectibles and the finish line stay where they
+    // were placed and the view scrolls over them. The view's top edge is at
+    // world y viewTop(); the player stays at view y playerY.
+    //
+    float viewTop() const { return -trackPos; }
+    float viewBottom() const { return cfg.viewHeight - trackPos; }
+    float toView(float worldY) const { return worldY + trackPos; }
+
+    // The player's box in world space.
+    SimRect playerBounds() const {
+        return { playerX, playerY + viewTop(), cfg.player.w * cfg.playerScale, cfg.player.h * cfg.playerScale };
+    }
+    template <int N>
+    static SimRect bounds(const EntityPool<N> &pool, int i) {
+        return { pool.x[i], pool.y[i], 2.f * pool.hw[i], 2.f * pool.hh[i] };
+    }
+    SimRect finishBounds() const {
+        float s = finishScale();
+        return { finishX, finishY, cfg.finishLine.w * s, cfg.finishLine.h * s };
+    }
+
+    // — INTERPOLATED VIEW (alpha in [0, 1] between the last two steps) —
+    template <int N>
+    static float entityY(const EntityPool<N> &pool, int i, float alpha) {
+        return lerpStep(pool.prevY[i], pool.y[i], alpha);
+    }
+    float playerXAt(float alpha) const { return lerpStep(prevPlayerX, playerX, alpha); }
+    float viewTopAt(float alpha) const { return -(trackPos - (1.f - alpha) * lastScroll); }
+
+    //
+    // Resets the player sprite position based on the lane.
+    //
+    void resetPlayer() {
+        SimRect pb = playerBounds();
+        playerX = laneCenter(playerLane) - pb.width / 2.f;
+        playerY = cfg.viewHeight - pb.height - 10.f;  // in the view
+        prevPlayerX = playerX;
+    }
+
+    //
+    // Starts a fresh race (what the LOADING screen does before switching to GAME).
+    // The same seed and the same inputs always give the same race.
+    //
+    void reset(std::uint64_t raceSeed) {
+        seed = raceSeed;
+        reset();
+    }
+
+    void reset() {
+        track.reset(seed);
+        cfg.lanes = std::max(1, std::min(cfg.lanes, static_cast<int>(LaneIndex<MAX_TREES>::MAX_LANES)));
+        state = GAME;
+        events = EVENT_NONE;
+        lives = cfg.startLives;
+        score = 0;
+        coinsCollected = bottlesCollected = 0;
+        stamina = cfg.maxStamina;
+        playerWorldSpeed = cfg.defaultSpeed;
+        boosting = braking = triedWhileExhausted = false;
+        hitTime = 0.f;
+        distanceTraveled = 0.f;
+        trackPos = 0.f;
+        lastRowAt = -1.f;
+        finishLineSpawned = finishTriggered = raceFinished = false;
+        finishTime = 0.f;
+        lastScroll = lastObstacleMove = 0.f;
+        trees.clear();
+        obstacles.clear();
+        bottles.clear();
+        coins.clear();
+        playerLane = cfg.startLane;
+        resetPlayer();
+    }
+
+    //
+    // The view changed size: re-center the player.
+    //
+    void resize(float w, float h) {
+        cfg.viewWidth = w;
+        cfg.viewHeight = h;
+        lastScroll = 0.f;
+        resetPlayer();
+    }
+
+    //
+    // Advances the race by dt seconds (normally STEP_DT), on the calling
+    // thread only (see JobSystem.hpp for why a step is not split up).
+    //
+    unsigned step(const RaceInput &in, float dt) {
+        events = EVENT_NONE;
+        if (state != GAME && state != HIT)
+            return events;
+
+        prevPlayerX = playerX;
+
+        // Lane changes snap the player into the new lane.
+        int targetLane = std::max(0, std::min(cfg.lanes - 1, playerLane + in.laneChange));
+        if (targetLane != playerLane) {
+            note(TELEMETRY_LANE, targetLane, playerLane);
+            playerLane = targetLane;
+            resetPlayer();
+        }
+
+        {
+            PROFILE_SCOPE(ZONE_SIM_SPEED);
+            events |= updateSpeed(cfg, *this, in, dt);
+            scrollTrack(dt);
+            updateFinishLine(dt);
+        }
+        {
+            PROFILE_SCOPE(ZONE_SIM_TRACK);
+            track.generateAhead(trackPos, cfg);
+        }
+        {
+            PROFILE_SCOPE(ZONE_SIM_TREES);
+            updateTrees();
+        }
+        {
+            PROFILE_SCOPE(ZONE_SIM_OBSTACLES);
+            updateObstacles(dt);
+        }
+        {
+            PROFILE_SCOPE(ZONE_SIM_SPEED);
+            slidePlayer(dt);
+        }
+
+        // Hit blink
+        if (state == HIT) {
+            hitTime += dt;
+            if (hitTime >= cfg.hitDuration)
+                state = GAME;
+        }
+
+        {
+            PROFILE_SCOPE(ZONE_SIM_BOTTLES);
+            updateBottles();
+        }
+        {
+            PROFILE_SCOPE(ZONE_SIM_COINS);
+            updateCoins();
+        }
+        return events;
+    }
+
+    //
+    // Writes the whole race (config, scalars, live entities with their lane
+    // indexes, the course) to w; loadState() puts it back, a copy per field.
+    // The collision masks and the telemetry are not part of it.
+    //
+    template <typename Writer>
+    void saveState(Writer &w) const {
+        stateScalars(w, *this);
+        track.save(w);
+        trees.save(w);
+        obstacles.save(w);
+        bottles.save(w);
+        coins.save(w);
+    }
+
+    template <typename Reader>
+    void loadState(Reader &r) {
+        stateScalars(r, *this);
+        track.load(r);
+        trees.load(r);
+        obstacles.load(r);
+        bottles.load(r);
+        coins.load(r);
+    }
+
+    //
+    // Speed and stamina for one step, returning EVENT_TIRED if boosting failed.
+    // Static so the autopilot's model (see Autopilot.hpp) runs the very same
+    // rules on its own state, which has fields of the same names.
+    //
+    template <typename Rider>
+    static unsigned updateSpeed(const RaceConfig &cfg, Rider &r, const RaceInput &in, float dt) {
+        unsigned events = EVENT_NONE;
+        r.boosting = false;
+        r.braking = false;
+
+        if (in.boost) {
+            if (r.stamina >= cfg.minStaminaToBoost) {
+                r.boosting = true;
+                r.stamina = std::max(0.f, r.stamina - cfg.staminaDrain * dt);
+                r.triedWhileExhausted = false;
+            } else if (!r.triedWhileExhausted) {
+                // Not enough stamina—play tired sound one time
+                events |= EVENT_TIRED;
+                r.triedWhileExhausted = true;
+            }
+        } else {
+            r.triedWhileExhausted = false;
+        }
+
+        if (in.brake)
+            r.braking = true;
+
+        if (!r.boosting)
+            r.stamina = std::min(cfg.maxStamina, r.stamina + cfg.staminaRegen * dt);
+
+        if (!r.raceFinished) r.distanceTraveled += r.playerWorldSpeed * dt;
+        r.stamina = std::min(cfg.maxStamina, r.stamina + cfg.staminaRegen * dt);
+
+        if (r.boosting)        r.playerWorldSpeed = std::min(r.playerWorldSpeed + cfg.accel * dt, cfg.maxSpeed);
+        else if (r.braking)    r.playerWorldSpeed = 0.f;
+        else {
+            if (r.playerWorldSpeed < cfg.defaultSpeed)
+                r.playerWorldSpeed = std::min(r.playerWorldSpeed + cfg.accel * dt, cfg.defaultSpeed);
+            else if (r.playerWorldSpeed > cfg.defaultSpeed)
+                r.playerWorldSpeed = std::max(r.playerWorldSpeed - cfg.brakeForce * dt, cfg.defaultSpeed);
+        }
+        return events;
+    }
+
+private:
+    // Every plain field, in the same order for saving (const Sim) and loading.
+    template <typename Io, typename Sim>
+    static void stateScalars(Io &io, Sim &s) {
+        io(s.cfg);
+        io(s.state);
+        io(s.events);
+        io(s.seed);
+        io(s.playerLane);
+        io(s.playerX);
+        io(s.playerY);
+        io(s.prevPlayerX);
+        io(s.lives);
+        io(s.score);
+        io(s.coinsCollected);
+        io(s.bottlesCollected);
+        io(s.stamina);
+        io(s.playerWorldSpeed);
+        io(s.boosting);
+        io(s.braking);
+        io(s.triedWhileExhausted);
+        io(s.hitTime);
+        io(s.distanceTraveled);
+        io(s.trackPos);
+        io(s.lastScroll);
+        io(s.lastObstacleMove);
+        io(s.finishLineSpawned);
+        io(s.finishTriggered);
+        io(s.raceFinished);
+        io(s.finishTime);
+        io(s.finishX);
+        io(s.finishY);
+        io(s.lastRowAt);
+    }
+
+    // Logs to the telemetry, if there is one.
+    void note(TelemetryEvent type, int arg, std::int32_t value, float x = 0.f, float y = 0.f) {
+        if (telemetry)
+            telemetry->log(type, arg, value, x, y);
+    }
+
+    void scrollTrack(float dt) {
+        lastScroll = playerWorldSpeed * dt;
+        trackPos += lastScroll;
+    }
+
+    void updateFinishLine(float dt) {
+        if (!finishLineSpawned &&
+            distanceTraveled >= cfg.raceDistance() - cfg.finishSpawnBefore) {
+            finishX = roadLeft();
+            finishY = viewTop() - cfg.finishLine.h * finishScale();
+            finishLineSpawned = true;
+        }
+        if (!finishLineSpawned)
+            return;
+
+        // Trigger on first contact
+        if (!finishTriggered && playerBounds().intersects(finishBounds())) {
+            finishTriggered = true;
+            finishTime = 0.f;
+            events |= EVENT_FINISH;
+        } else if (finishTriggered) {
+            finishTime += dt;
+        }
+
+        if (finishTriggered && finishTime >= cfg.finishDelay) {
+            state = FINISH;
+            raceFinished = true;
+        }
+    }
+
+    // World y of the top of a track item `h` high: its bottom edge is where
+    // the view's top edge was at track position `at`.
+    static float releaseTop(const TrackItem &item, float h) { return -item.at - h; }
+
+    void updateTrees() {
+        track.release(TRACK_TREES, trackPos, [&](const TrackItem &item) {
+            float tw = cfg.trees[item.kind].w, th = cfg.trees[item.kind].h;
+            float rw = cfg.road.w, roadL = roadLeft(), winW = cfg.viewWidth;
+            float tx = item.lane == 0
+                     ? (roadL > tw ? std::floor(item.u * (roadL - tw + 1)) : 0)
+                     : (winW - (roadL + rw) > tw
+                        ? roadL + rw + std::floor(item.u * (winW - roadL - rw - tw + 1))
+                        : winW - tw);
+            if (trees.spawn(tx, releaseTop(item, th), tw / 2.f, th / 2.f, 0, item.kind) >= 0)
+                note(TELEMETRY_SPAWN, TRACK_TREES, item.kind, tx, releaseTop(item, th));
+            return true;
+        });
+        trees.removeBelow(viewBottom());
+    }
+
+    void updateObstacles(float dt) {
+        // They drive down the view at obstacleSpeed, whatever the player's speed.
+        float obstacleMove = (braking ? -cfg.obstacleSpeed : cfg.obstacleSpeed) * dt;
+        lastObstacleMove = obstacleMove - lastScroll;
+        obstacles.move(lastObstacleMove);
+
+        // Obstacles drive at their own speed, so a row waits until the one
+        // before it has pulled 150 px ahead (none with minGapScale 0).
+        float rowGap = 150.f * cfg.minGapScale;
+        track.release(TRACK_OBSTACLES, trackPos, [&](const TrackItem &item) {
+            if (rowGap > 0.f && item.at != lastRowAt && obstacles.newest() >= 0 &&
+                toView(obstacles.y[obstacles.newest()]) <= rowGap)
+                return false;
+            float ow = cfg.obstacles[item.kind].w * cfg.obstacleScale;
+            float oh = cfg.obstacles[item.kind].h * cfg.obstacleScale;
+            float ox = laneCenter(item.lane) - ow / 2.f, oy = viewTop() - oh - 50.f;
+            if (obstacles.spawn(ox, oy, ow / 2.f, oh / 2.f, item.lane, item.kind) >= 0)
+                note(TELEMETRY_SPAWN, TRACK_OBSTACLES, item.kind, ox, oy);
+            lastRowAt = item.at;
+            return true;
+        });
+
+        // Only obstacles in the lanes under the player, near its height, can
+        // hit it. Boxes that overlap are then checked pixel by pixel with the
+        // collision masks; without masks both boxes are cut to half their width.
+        if (state == GAME) {
+            bool pixelExact = masks && masks->complete();
+            SimRect pb = playerBounds();
+            if (!pixelExact) { pb.left += pb.width * 0.25f; pb.width *= 0.5f; }
+            int first, last, hit = -1;
+            laneSpan(pb.left, pb.left + pb.width, obstacles.maxHalfWidth(), first, last);
+            obstacles.query(first, last, pb.top, pb.top + pb.height, [&](int i) {
+                SimRect ob = bounds(obstacles, i);
+                if (!pixelExact) { ob.left += ob.width * 0.25f; ob.width *= 0.5f; }
+                if (!pb.intersects(ob))
+                    return false;
+                if (pixelExact &&
+                    !masks->player.overlaps(masks->obstacles[obstacles.kind[i]],
+                                            static_cast<int>(std::lround(ob.left - pb.left)),
+                                            static_cast<int>(std::lround(ob.top - pb.top))))
+                    return false;
+                hit = i;
+                return true;
+            });
+            if (hit >= 0) {
+                note(TELEMETRY_CRASH, obstacles.kind[hit], lives - 1, obstacles.x[hit], obstacles.y[hit]);
+                events |= EVENT_CRASH;
+                lives--;
+                if (lives <= 0) state = MENU; else { state = HIT; hitTime = 0.f; }
+                obstacles.remove(hit);
+            }
+        }
+        score += 10 * obstacles.removeBelow(viewBottom());
+    }
+
+    // Smooth lane movement
+    void slidePlayer(float dt) {
+        float playerTargetX = laneCenter(playerLane) - playerBounds().width / 2.f;
+        float slide = cfg.laneSlide * dt;
+        if (playerX + slide < playerTargetX) playerX += slide;
+        else if (playerX - slide > playerTargetX) playerX -= slide;
+        else playerX = playerTargetX;
+    }
+
+    //
+    // Checks a new collectible's box against the other collectibles (vertical
+    // spacing with its own kind in any lane, overlap with the other kind) and
+    // the obstacles, looking only at the neighbours found through the lane index.
+    //
+    template <int A, int B>
+    bool spawnIsClear(const SimRect &box, const EntityPool<A> &same, const EntityPool<B> &other) const {
+        float gap = 100.f * cfg.minGapScale;
+        for (int l = 0; l < cfg.lanes && gap > 0.f; ++l) {
+            bool tooClose = same.lanes.query(l, box.top - gap, box.top + gap, same.y, [&](int i) {
+                return std::abs(same.y[i] - box.top) < gap;
+            });
+            if (tooClose)
+                return false;
+        }
+        auto overlaps = [&](const auto &pool) {
+            int first, last;
+            laneSpan(box.left, box.left + box.width, pool.maxHalfWidth(), first, last);
+            return pool.query(first, last, box.top, box.top + box.height, [&](int i) {
+                return box.intersects(bounds(pool, i));
+            });
+        };
+        return !overlaps(obstacles) && !overlaps(other);
+    }
+
+    //
+    // Brings the collectibles of `type` that came into view into pool, unless
+    // they would overlap obstacles or the other kind of collectible.
+    //
+    template <int A, int B>
+    void releaseCollectibles(TrackItemType type, EntityPool<A> &pool, const EntityPool<B> &other,
+                             const SpriteSize &size, float scale) {
+        track.release(type, trackPos, [&](const TrackItem &item) {
+            float w = size.w * scale, h = size.h * scale;
+            SimRect box = { laneCenter(item.lane) - w / 2.f, releaseTop(item, h), w, h };
+            if (spawnIsClear(box, pool, other) && pool.spawn(box.left, box.top, w / 2.f, h / 2.f, item.lane, 0) >= 0)
+                note(TELEMETRY_SPAWN, type, 0, box.left, box.top);
+            return true;
+        });
+    }
+
+    //
+    // Removes and returns the first entity of pool touching the player, or -1.
+    //
+    template <int N>
+    int pickUp(EntityPool<N> &pool) {
+        SimRect pb = playerBounds();
+        int first, last, hit = -1;
+        laneSpan(pb.left, pb.left + pb.width, pool.maxHalfWidth(), first, last);
+        pool.query(first, last, pb.top, pb.top + pb.height, [&](int i) {
+            if (!pb.intersects(bounds(pool, i)))
+                return false;
+            hit = i;
+            return true;
+        });
+        if (hit >= 0)
+            pool.remove(hit);
+        return hit;
+    }
+
+    //
+    // Lets new bottles in and handles player collection (stamina boost).
+    //
+    void updateBottles() {
+        releaseCollectibles(TRACK_BOTTLES, bottles, coins, cfg.bottle, cfg.bottleScale);
+        while (pickUp(bottles) >= 0) {
+            events |= EVENT_DRINK;
+            stamina = std::min(cfg.maxStamina, stamina + cfg.bottleStamina);
+            ++bottlesCollected;
+            note(TELEMETRY_PICKUP, TRACK_BOTTLES, score, stamina);
+        }
+        bottles.removeBelow(viewBottom());
+    }
+
+    //
+    // Lets new coins in and handles player collection (+100 score).
+    //
+    void updateCoins() {
+        releaseCollectibles(TRACK_COINS, coins, bottles, cfg.coin, cfg.coinScale);
+        while (pickUp(coins) >= 0) {
+            events |= EVENT_COIN;
+            score += 100;
+            ++coinsCollected;
+            note(TELEMETRY_PICKUP, TRACK_COINS, score, stamina);
+        }
+        coins.removeBelow(viewBottom());
+    }
+};
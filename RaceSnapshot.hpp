@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#include "RaceSimulation.hpp"
+
+//
+// Everything the renderer needs from one simulation step, copied out of a
+// RaceSimulation so that it can be drawn on another thread while the
+// simulation keeps stepping. Only the live part of each entity pool is
+// copied. Positions are in world space, like on RaceSimulation, and so is
+// interpolation: alpha in [0, 1] blends the step before this one into this one.
+//
+
+template <int Capacity>
+struct PoolSnapshot {
+    int count = 0;
+    float x[Capacity];
+    float y[Capacity];
+    float prevY[Capacity];
+    std::uint8_t kind[Capacity];
+
+    void capture(const EntityPool<Capacity> &pool) {
+        count = pool.size();
+        std::copy(pool.x, pool.x + count, x);
+        std::copy(pool.y, pool.y + count, y);
+        std::copy(pool.prevY, pool.prevY + count, prevY);
+        std::copy(pool.kind, pool.kind + count, kind);
+    }
+
+    int size() const { return count; }
+    float yAt(int i, float alpha) const { return lerpStep(prevY[i], y[i], alpha); }
+};
+
+struct RaceSnapshot {
+    std::chrono::steady_clock::time_point time;  // when the last step finished
+    bool replayEnded = false;                    // the replay being played ran out of input
+    int lockstepFrames = 0;                      // FRAME commands taken since the race started
+
+    RaceConfig cfg;
+    GameState state = GAME;
+    int lives = 0, score = 0;
+    float stamina = 0.f, hitTime = 0.f, distanceTraveled = 0.f, trackPos = 0.f;
+    float playerX = 0.f, prevPlayerX = 0.f, playerY = 0.f;
+    float roadLeft = 0.f;
+    bool finishLineSpawned = false;
+    float finishX = 0.f, finishY = 0.f, finishScale = 1.f;
+    float lastScroll = 0.f;
+
+    PoolSnapshot<RaceSimulation::MAX_TREES> trees;
+    PoolSnapshot<RaceSimulation::MAX_OBSTACLES> obstacles;
+    PoolSnapshot<RaceSimulation::MAX_BOTTLES> bottles;
+    PoolSnapshot<RaceSimulation::MAX_COINS> coins;
+
+    void capture(const RaceSimulation &sim) {
+        cfg = sim.cfg;
+        state = sim.state;
+        lives = sim.lives;
+        score = sim.score;
+        stamina = sim.stamina;
+        hitTime = sim.hitTime;
+        distanceTraveled = sim.distanceTraveled;
+        trackPos = sim.trackPos;
+        playerX = sim.playerX;
+        prevPlayerX = sim.prevPlayerX;
+        playerY = sim.playerY;
+        roadLeft = sim.roadLeft();
+        finishLineSpawned = sim.finishLineSpawned;
+        finishX = sim.finishX;
+        finishY = sim.finishY;
+        finishScale = sim.finishScale();
+        lastScroll = sim.lastScroll;
+        trees.capture(sim.trees);
+        obstacles.capture(sim.obstacles);
+        bottles.capture(sim.bottles);
+        coins.capture(sim.coins);
+    }
+
+    int entityCount() const { return 1 + trees.size() + obstacles.size() + bottles.size() + coins.size(); }
+
+    // — INTERPOLATED VIEW, same as RaceSimulation's —
+    float playerXAt(float alpha) const { return lerpStep(prevPlayerX, playerX, alpha); }
+    float viewTopAt(float alpha) const { return -(trackPos - (1.f - alpha) * lastScroll); }
+
+    // Interpolation factor for drawing this snapshot at time `now`.
+    float alphaAt(std::chrono::steady_clock::time_point now) const {
+        float since = std::chrono::duration<float>(now - time).count();
+        return std::max(0.f, std::min(1.f, since / RaceSimulation::STEP_DT));
+    }
+};
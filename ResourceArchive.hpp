@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//
+// Packed resource archive (resources.pak), written at build time by
+// tools/pack_resources. Images are stored as raw RGBA8 pixels and sounds as
+// 16-bit PCM samples, so the game builds textures and sound buffers straight
+// from the mapped file: one open, no PNG inflate, no WAV parsing. Anything
+// else (fonts, streamed music) is stored as the original bytes.
+//
+// File layout (native endianness, payloads 16-byte aligned):
+//   ArchiveHeader | ArchiveEntry[count] | names | payloads
+// Entry names are paths relative to resources/, e.g. "images/trees/tree1.png".
+//
+
+struct ArchiveHeader {
+    char magic[4];               // "BKRA"
+    std::uint32_t version;
+    std::uint32_t count;         // number of entries
+    std::uint32_t namesSize;     // bytes of the name blob after the entries
+};
+
+struct ArchiveEntry {
+    enum Kind : std::uint32_t { RAW, IMAGE, SOUND };
+
+    std::uint32_t kind;
+    std::uint32_t nameOffset, nameSize;  // into the name blob
+    std::uint32_t a, b;                  // IMAGE: width, height  SOUND: channels, sample rate
+    std::uint32_t reserved;
+    std::uint64_t offset, size;          // payload, from the start of the file
+};
+
+static const std::uint32_t ARCHIVE_VERSION = 1;
+
+// Read-only view of a mapped archive. Pointers stay valid while it lives.
+class ResourceArchive {
+public:
+    // A file inside the archive.
+    struct Resource {
+        const ArchiveEntry *entry = nullptr;
+        const void *data = nullptr;
+
+        explicit operator bool() const { return entry != nullptr; }
+        std::size_t size() const { return static_cast<std::size_t>(entry->size); }
+        const std::uint8_t *pixels() const { return static_cast<const std::uint8_t *>(data); }
+        unsigned width() const { return entry->a; }
+        unsigned height() const { return entry->b; }
+        const std::int16_t *samples() const { return static_cast<const std::int16_t *>(data); }
+        std::uint64_t sampleCount() const { return entry->size / sizeof(std::int16_t); }
+        unsigned channels() const { return entry->a; }
+        unsigned sampleRate() const { return entry->b; }
+    };
+
+    ResourceArchive() = default;
+    ResourceArchive(const ResourceArchive &) = delete;
+    ResourceArchive &operator=(const ResourceArchive &) = delete;
+    ~ResourceArchive() { close(); }
+
+    // Maps the archive. Returns false (and stays closed) if it is missing or invalid.
+    bool open(const std::string &path) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                m_data = static_cast<const std::uint8_t *>(p);
+                m_size = static_cast<std::size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+#else
+        // No mmap here: read the whole file in one go instead.
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (in) {
+            m_copy.resize(static_cast<std::size_t>(in.tellg()));
+            in.seekg(0);
+            if (in.read(reinterpret_cast<char *>(m_copy.data()), m_copy.size())) {
+                m_data = m_copy.data();
+                m_size = m_copy.size();
+            }
+        }
+#endif
+        if (!m_data || !validate()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (m_data)
+            munmap(const_cast<std::uint8_t *>(m_data), m_size);
+#else
+        m_copy.clear();
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    // Looks a file up by its path; a leading "resources/" is ignored.
+    Resource find(const std::string &path) const {
+        Resource r;
+        if (!m_data)
+            return r;
+        std::string name = path.compare(0, 10, "resources/") == 0 ? path.substr(10) : path;
+        for (std::uint32_t i = 0; i < header().count; ++i) {
+            const ArchiveEntry &e = entries()[i];
+            if (e.nameSize == name.size() && std::memcmp(names() + e.nameOffset, name.data(), name.size()) == 0) {
+                r.entry = &e;
+                r.data = m_data + e.offset;
+                return r;
+            }
+        }
+        return r;
+    }
+
+private:
+    const ArchiveHeader &header() const { return *reinterpret_cast<const ArchiveHeader *>(m_data); }
+    const ArchiveEntry *entries() const { return reinterpret_cast<const ArchiveEntry *>(m_data + sizeof(ArchiveHeader)); }
+    const char *names() const {
+        return reinterpret_cast<const char *>(entries() + header().count);
+    }
+
+    // Checks that the table of contents and every payload lie inside the file.
+    bool validate() const {
+        if (m_size < sizeof(ArchiveHeader) || std::memcmp(header().magic, "BKRA", 4) != 0 ||
+            header().version != ARCHIVE_VERSION)
+            return false;
+        std::uint64_t tocEnd = sizeof(ArchiveHeader) + std::uint64_t(header().count) * sizeof(ArchiveEntry) + header().namesSize;
+        if (tocEnd > m_size)
+            return false;
+        for (std::uint32_t i = 0; i < header().count; ++i) {
+            const ArchiveEntry &e = entries()[i];
+            if (std::uint64_t(e.nameOffset) + e.nameSize > header().namesSize ||
+                e.offset > m_size || e.size > m_size - e.offset)
+                return false;
+            if (e.kind == ArchiveEntry::IMAGE && e.size != std::uint64_t(e.a) * e.b * 4)
+                return false;
+        }
+        return true;
+    }
+
+    const std::uint8_t *m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    std::vector<std::uint8_t> m_copy;
+#endif
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+//
+// Cached picture of the static part of a screen (menu background, titles,
+// unselected items). compose() tells the caller whether the picture has to
+// be drawn again, which is only the case when the window size or the key
+// (whatever the picture depends on: state, selected item...) changed or it
+// was invalidated. present() then puts it on the window as a single quad,
+// and only the animated parts are drawn on top every frame.
+//
+// If render textures are not available, compose() returns the window itself
+// every frame and the screen is simply drawn directly, as before.
+//
+class ScreenCache {
+public:
+    void invalidate() { m_valid = false; }
+
+    //
+    // Returns where to draw the static layer this frame: the (cleared) cache
+    // when it is out of date, the window when caching is unavailable, or
+    // nullptr when the cached picture can be used as it is.
+    //
+    sf::RenderTarget *compose(sf::RenderWindow &window, int key) {
+        sf::Vector2u size = window.getSize();
+        if (m_failed)
+            return &window;
+        if (m_valid && size == m_size && key == m_key)
+            return nullptr;
+        if (size != m_size) {
+            if (!m_texture.create(size.x, size.y)) {
+                m_failed = true;
+                return &window;
+            }
+            m_size = size;
+        }
+        m_key = key;
+        m_valid = true;
+        m_composing = true;
+        m_texture.clear();
+        return &m_texture;
+    }
+
+    // Draws the static layer onto the window.
+    void present(sf::RenderWindow &window) {
+        if (m_failed)
+            return;
+        if (m_composing) {
+            m_texture.display();
+            m_sprite.setTexture(m_texture.getTexture(), true);
+            m_composing = false;
+        }
+        window.draw(m_sprite);
+    }
+
+private:
+    sf::RenderTexture m_texture;
+    sf::Sprite m_sprite;
+    sf::Vector2u m_size;
+    int m_key = 0;
+    bool m_valid = false;
+    bool m_composing = false;
+    bool m_failed = false;
+};
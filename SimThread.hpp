@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Autopilot.hpp"
+#include "LockFree.hpp"
+#include "Profiler.hpp"
+#include "RaceHistory.hpp"
+#include "RaceRecording.hpp"
+#include "RaceSimulation.hpp"
+#include "RaceSnapshot.hpp"
+
+// Main thread -> simulation thread.
+struct SimCommand {
+    enum Type { INPUT, RESIZE, FRAME };
+    Type type = INPUT;
+    RaceInput input;      // INPUT, FRAME: lane changes add up, boost / brake are the latest state
+    float w = 0.f, h = 0.f;  // RESIZE: new view size
+    float dt = 0.f;       // FRAME: lockstep mode only, simulated time to advance
+};
+
+//
+// Runs a RaceSimulation on its own thread. While a race is on, the thread
+// steps it in real time on its own clock (or, in lockstep mode, exactly as
+// far as FRAME commands say), publishes a RaceSnapshot after every batch of
+// steps through a triple buffer and reports race events through an SPSC
+// queue; input and resizes come in through another SPSC queue. The render
+// thread never waits on the simulation and vice versa, except that a bench
+// waits for each lockstep frame it sent (RaceSnapshot::lockstepFrames).
+//
+// The thread stops stepping by itself when the race leaves GAME / HIT (or a
+// replay runs out). While it is paused, the main thread owns the simulation
+// again and may reset, resize or read it directly.
+//
+class SimThread {
+public:
+    explicit SimThread(RaceSimulation &sim) : m_sim(sim), m_thread([this] { run(); }) {}
+
+    ~SimThread() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+            m_running = false;
+        }
+        m_wake.notify_all();
+        m_thread.join();
+    }
+
+    SimThread(const SimThread &) = delete;
+    SimThread &operator=(const SimThread &) = delete;
+
+    //
+    // Starts stepping the (already reset) race. With a recording every step's
+    // input is recorded; with a replay the recorded input is used instead of
+    // the commands. Only call while paused. Commands and events still queued
+    // from before (a demo race, the end of the last one) are dropped.
+    //
+    void start(bool lockstep, RaceRecording *recording, RaceReplay *replay) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        SimCommand stale;
+        while (m_commands.pop(stale)) {}
+        takeEvents();
+        m_lockstep = lockstep;
+        m_recording = recording;
+        m_replay = replay;
+        m_input = RaceInput();
+        if (m_autopilot)
+            m_autopilot->reset();
+        m_accumulator = 0.f;
+        m_lockstepFrames = 0;
+        m_last = std::chrono::steady_clock::now();
+        publish(false);
+        m_running = true;
+        m_wake.notify_all();
+    }
+
+    // With an autopilot set, it drives every step instead of the INPUT
+    // commands (a replay still plays its recorded input). Only call while paused.
+    void setAutopilot(Autopilot *autopilot) { m_autopilot = autopilot; }
+
+    // With a history set, every step is recorded into it. Only call while paused.
+    void setHistory(RaceHistory *history) { m_history = history; }
+
+    //
+    // Picks a pause()d race up again where it stopped, without catching up
+    // on the time it spent paused. Queued input and events are kept, and so
+    // is the autopilot's plan; only what the race is now (after a rewind)
+    // gets published again.
+    //
+    void resume() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_last = std::chrono::steady_clock::now();
+        publish(false);
+        m_running = true;
+        m_wake.notify_all();
+    }
+
+    // Stops stepping and waits until the thread has let go of the simulation.
+    void pause() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_running = false;
+        m_wake.notify_all();
+        m_idleChanged.wait(lock, [this] { return m_idle; });
+    }
+
+    bool running() const { return m_running; }
+
+    // Main thread: queues input, a resize or a lockstep frame. Drops it if
+    // the simulation is more than a queue behind.
+    bool send(const SimCommand &cmd) { return m_commands.push(cmd); }
+
+    // Main thread: newest published snapshot.
+    const RaceSnapshot &snapshot() {
+        m_snapshots.update();
+        return m_snapshots.front();
+    }
+
+    // Main thread: race events (EVENT_* bits) raised since the last call.
+    unsigned takeEvents() {
+        unsigned all = EVENT_NONE, e;
+        while (m_events.pop(e))
+            all |= e;
+        return all;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_quit) {
+            if (!m_running) {
+                m_idle = true;
+                m_idleChanged.notify_all();
+                m_wake.wait(lock, [this] { return m_running || m_quit; });
+                m_idle = false;
+                continue;
+            }
+            lock.unlock();
+            bool keepGoing = tick();
+            lock.lock();
+            if (!keepGoing)
+                m_running = false;
+        }
+        m_idle = true;
+        m_idleChanged.notify_all();
+    }
+
+    // Applies queued commands, runs every step that is due and publishes the result.
+    bool tick() {
+        using Clock = std::chrono::steady_clock;
+        SimCommand cmd;
+        bool framed = false;
+        while (m_commands.pop(cmd)) {
+            if (cmd.type == SimCommand::RESIZE) {
+                if (!m_replay) {  // a replay only follows the resizes it recorded
+                    m_sim.resize(cmd.w, cmd.h);
+                    if (m_recording)
+                        m_recording->recordResize(m_sim.cfg.viewWidth, m_sim.cfg.viewHeight);
+                }
+                continue;
+            }
+            m_input.laneChange += cmd.input.laneChange;
+            m_input.boost = cmd.input.boost;
+            m_input.brake = cmd.input.brake;
+            if (cmd.type == SimCommand::FRAME) {
+                m_accumulator += cmd.dt;
+                ++m_lockstepFrames;
+                framed = true;
+            }
+        }
+
+        // A very long stall (debugger, suspended process) is capped so we
+        // don't try to catch up seconds of simulation at once.
+        if (!m_lockstep) {
+            const float MAX_FRAME_DT = 0.25f;
+            Clock::time_point now = Clock::now();
+            m_accumulator += std::min(std::chrono::duration<float>(now - m_last).count(), MAX_FRAME_DT);
+            m_last = now;
+        }
+
+        unsigned events = EVENT_NONE;
+        bool stepped = false, replayEnded = false;
+        {
+            PROFILE_SCOPE(ZONE_SIM);
+            while (m_accumulator >= RaceSimulation::STEP_DT) {
+                RaceInput in = m_input;
+                if (m_replay && !m_replay->next(m_sim, in)) {
+                    replayEnded = true;
+                    break;
+                }
+                if (m_autopilot && !m_replay)
+                    in = m_autopilot->drive(m_sim);
+                events |= m_sim.step(in, RaceSimulation::STEP_DT);
+                if (m_recording)
+                    m_recording->recordStep(in);
+                if (m_history)
+                    m_history->record(m_sim);
+                m_input.laneChange = 0;  // lane changes go to the first step only
+                m_accumulator -= RaceSimulation::STEP_DT;
+                stepped = true;
+                if (m_sim.state != GAME && m_sim.state != HIT)
+                    break;
+            }
+        }
+        if (events != EVENT_NONE)
+            m_events.push(events);
+        if (stepped || replayEnded || framed)
+            publish(replayEnded);
+        if (replayEnded || (m_sim.state != GAME && m_sim.state != HIT))
+            return false;
+
+        // Sleep until the next step is due. In lockstep the render thread
+        // waits for each frame, so the next one is polled for without sleeping.
+        if (m_lockstep) {
+            std::this_thread::yield();
+            return true;
+        }
+        float wait = RaceSimulation::STEP_DT - m_accumulator;
+        std::this_thread::sleep_for(std::chrono::duration<float>(std::max(wait, 0.f)));
+        return true;
+    }
+
+    void publish(bool replayEnded) {
+        RaceSnapshot &s = m_snapshots.back();
+        s.capture(m_sim);
+        s.replayEnded = replayEnded;
+        s.lockstepFrames = m_lockstepFrames;
+        s.time = std::chrono::steady_clock::now();
+        m_snapshots.publish();
+    }
+
+    RaceSimulation &m_sim;
+
+    // Owned by the simulation thread while running.
+    bool m_lockstep = false;
+    RaceRecording *m_recording = nullptr;
+    RaceReplay *m_replay = nullptr;
+    Autopilot *m_autopilot = nullptr;
+    RaceHistory *m_history = nullptr;
+    int m_lockstepFrames = 0;
+    RaceInput m_input;
+    float m_accumulator = 0.f;
+    std::chrono::steady_clock::time_point m_last;
+
+    TripleBuffer<RaceSnapshot> m_snapshots;
+    SpscQueue<SimCommand, 256> m_commands;
+    SpscQueue<unsigned, 64> m_events;
+
+    std::mutex m_mutex;  // only for starting / pausing, never per step
+    std::condition_variable m_wake, m_idleChanged;
+    std::atomic<bool> m_running{ false };
+    bool m_idle = false;
+    bool m_quit = false;
+    std::thread m_thread;  // last, so everything above exists when it starts
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <vector>
+
+#include "TextureAtlas.hpp"
+
+//
+// Sprite batcher: instead of one window.draw per sprite, quads are collected
+// into sf::VertexArrays grouped by layer and texture, and each group is
+// submitted with a single draw call. Layers are drawn back to front; inside a
+// layer, groups are drawn in the order their texture was first used. A layer
+// can be given its own view (the race's scrolling camera); the others are
+// drawn through the target's view.
+//
+
+enum BatchLayer { LAYER_GRASS, LAYER_ROAD, LAYER_SHADOWS, LAYER_ENTITIES, LAYER_HUD, LAYER_TEXT, LAYER_COUNT };
+
+class SpriteBatch {
+public:
+    // Forget last frame's quads and views but keep every buffer's capacity.
+    void clear() {
+        for (auto &layer : m_layers)
+            for (auto &group : layer)
+                group.verts.clear();
+        std::fill(m_hasView, m_hasView + LAYER_COUNT, false);
+    }
+
+    // Draws `layer` through `view` until the next clear().
+    void setView(BatchLayer layer, const sf::View &view) {
+        m_views[layer] = view;
+        m_hasView[layer] = true;
+    }
+
+    //
+    // Adds a textured quad: texRect is in texture pixels (may go past the
+    // texture size on repeated textures), the quad is texRect scaled by
+    // (sx, sy) with its top-left corner at (x, y).
+    //
+    void add(BatchLayer layer, const sf::Texture *tex, const sf::FloatRect &texRect,
+             float x, float y, float sx, float sy, const sf::Color &color = sf::Color::White) {
+        float w = texRect.width * sx, h = texRect.height * sy;
+        float u0 = texRect.left, v0 = texRect.top;
+        float u1 = u0 + texRect.width, v1 = v0 + texRect.height;
+        sf::VertexArray &va = group(layer, tex);
+        va.append(sf::Vertex({ x,     y     }, color, { u0, v0 }));
+        va.append(sf::Vertex({ x + w, y     }, color, { u1, v0 }));
+        va.append(sf::Vertex({ x,     y + h }, color, { u0, v1 }));
+        va.append(sf::Vertex({ x,     y + h }, color, { u0, v1 }));
+        va.append(sf::Vertex({ x + w, y     }, color, { u1, v0 }));
+        va.append(sf::Vertex({ x + w, y + h }, color, { u1, v1 }));
+    }
+
+    // Adds a whole texture at (x, y) with the given scale.
+    void add(BatchLayer layer, const sf::Texture &tex, float x, float y,
+             float scale = 1.f, const sf::Color &color = sf::Color::White) {
+        sf::Vector2u s = tex.getSize();
+        add(layer, &tex, sf::FloatRect(0.f, 0.f, static_cast<float>(s.x), static_cast<float>(s.y)),
+            x, y, scale, scale, color);
+    }
+
+    // Adds an atlas region at (x, y) with the given scale.
+    void add(BatchLayer layer, const AtlasRegion &region, float x, float y,
+             float scale = 1.f, const sf::Color &color = sf::Color::White) {
+        if (region.texture)
+            add(layer, region.texture, region.rect, x, y, scale, scale, color);
+    }
+
+    // Adds a flat colored rectangle (HUD bars).
+    void addRect(BatchLayer layer, float x, float y, float w, float h, const sf::Color &color) {
+        add(layer, nullptr, sf::FloatRect(0.f, 0.f, w, h), x, y, 1.f, 1.f, color);
+    }
+
+    // Draws every non-empty group, layer by layer.
+    void draw(sf::RenderTarget &target) {
+        m_drawCalls = 0;
+        sf::View targetView = target.getView();
+        bool ownView = false;
+        for (int l = 0; l < LAYER_COUNT; ++l) {
+            if (m_hasView[l] || ownView)
+                target.setView(m_hasView[l] ? m_views[l] : targetView);
+            ownView = m_hasView[l];
+            for (auto &group : m_layers[l]) {
+                if (group.verts.getVertexCount() == 0)
+                    continue;
+                sf::RenderStates states;
+                states.texture = group.texture;
+                target.draw(group.verts, states);
+                ++m_drawCalls;
+            }
+        }
+        if (ownView)
+            target.setView(targetView);
+    }
+
+    // Draw calls issued by the last draw().
+    unsigned drawCalls() const { return m_drawCalls; }
+
+private:
+    struct Group {
+        const sf::Texture *texture;
+        sf::VertexArray verts;
+    };
+
+    sf::VertexArray &group(BatchLayer layer, const sf::Texture *tex) {
+        for (auto &g : m_layers[layer])
+            if (g.texture == tex)
+                return g.verts;
+        m_layers[layer].push_back(Group{ tex, sf::VertexArray(sf::Triangles) });
+        return m_layers[layer].back().verts;
+    }
+
+    std::vector<Group> m_layers[LAYER_COUNT];
+    sf::View m_views[LAYER_COUNT];
+    bool m_hasView[LAYER_COUNT] = {};
+    unsigned m_drawCalls = 0;
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LockFree.hpp"
+
+//
+// Session telemetry: gameplay and frame events as fixed-size binary records.
+// Any thread log()s into a lock-free MPSC ring (a clock read and a few
+// stores); a background thread drains it into a log that rotates over
+// MAX_FILES files of up to FILE_BYTES each. If the ring is ever full the
+// record is dropped and counted, and the writer logs how many were lost.
+// tools/telemetry_csv turns the files into CSV.
+//
+// File layout (native endianness):
+//   "BKTL" | u32 version | u32 sizeof(TelemetryRecord) | u32 file number
+//   | u64 session start (ms since the Unix epoch) | records
+//
+
+enum TelemetryEvent : std::uint16_t {
+    TELEMETRY_FRAME,    // arg: target fps, value: frame interval (us)
+    TELEMETRY_STATE,    // arg: new GameState, value: previous one
+    TELEMETRY_SPAWN,    // arg: TrackItemType, value: kind, x / y: world position
+    TELEMETRY_PICKUP,   // arg: TrackItemType, value: score, x: stamina (after the pickup)
+    TELEMETRY_CRASH,    // arg: obstacle kind, value: lives left, x / y: obstacle world position
+    TELEMETRY_LANE,     // arg: new lane, value: previous lane
+    TELEMETRY_DROPPED,  // value: records lost because the ring was full
+    TELEMETRY_EVENT_COUNT
+};
+
+inline const char *telemetryEventName(int e) {
+    static const char *names[TELEMETRY_EVENT_COUNT] = {
+        "frame", "state", "spawn", "pickup", "crash", "lane", "dropped"
+    };
+    return e >= 0 && e < TELEMETRY_EVENT_COUNT ? names[e] : "?";
+}
+
+struct TelemetryRecord {
+    std::uint64_t time = 0;  // ns since the session started
+    std::uint16_t type = 0;  // TelemetryEvent
+    std::uint16_t arg = 0;
+    std::int32_t value = 0;
+    float x = 0.f, y = 0.f;
+};
+
+static_assert(sizeof(TelemetryRecord) == 24, "telemetry records are written as raw bytes");
+
+class Telemetry {
+public:
+    static constexpr std::uint32_t VERSION = 1;
+    static const std::size_t RING = 8192;              // records in flight
+    static const long FILE_BYTES = 4 * 1024 * 1024;    // a bit over 170k records
+    static const int MAX_FILES = 4;                    // older files are deleted
+
+    ~Telemetry() { close(); }
+
+    //
+    // Starts the session: the log goes to path.0, path.1, ... Returns false
+    // if the first file can't be created.
+    //
+    bool open(const std::string &path) {
+        close();
+        m_path = path;
+        m_fileNumber = 0;
+        m_start = Clock::now();
+        m_startMs = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        if (!openFile())
+            return false;
+        m_quit = false;
+        m_thread = std::thread([this] { run(); });
+        return true;
+    }
+
+    // Writes out everything logged so far and stops the writer.
+    void close() {
+        if (!m_thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+        }
+        m_wake.notify_all();
+        m_thread.join();
+    }
+
+    // Any thread, any time after open().
+    void log(TelemetryEvent type, int arg, std::int32_t value, float x = 0.f, float y = 0.f) {
+        TelemetryRecord r;
+        r.time = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - m_start).count());
+        r.type = type;
+        r.arg = static_cast<std::uint16_t>(arg);
+        r.value = value;
+        r.x = x;
+        r.y = y;
+        if (!m_ring->push(r))
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Writer thread: drains the ring every DRAIN_MS (and once more on close).
+    void run() {
+        static const int DRAIN_MS = 20;
+        std::vector<TelemetryRecord> batch;
+        batch.reserve(RING);
+        bool quit = false;
+        while (!quit) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait_for(lock, std::chrono::milliseconds(DRAIN_MS), [this] { return m_quit; });
+                quit = m_quit;
+            }
+            TelemetryRecord r;
+            while (m_ring->pop(r))
+                batch.push_back(r);
+            if (std::uint32_t lost = m_dropped.exchange(0, std::memory_order_relaxed)) {
+                TelemetryRecord d;
+                d.time = batch.empty() ? 0 : batch.back().time;
+                d.type = TELEMETRY_DROPPED;
+                d.value = static_cast<std::int32_t>(lost);
+                batch.push_back(d);
+            }
+            write(batch);
+            batch.clear();
+        }
+        if (m_file)
+            std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    void write(const std::vector<TelemetryRecord> &batch) {
+        if (batch.empty() || !m_file)
+            return;
+        std::fwrite(batch.data(), sizeof(TelemetryRecord), batch.size(), m_file);
+        std::fflush(m_file);
+        m_fileBytes += static_cast<long>(batch.size() * sizeof(TelemetryRecord));
+        if (m_fileBytes >= FILE_BYTES) {
+            std::fclose(m_file);
+            m_file = nullptr;
+            ++m_fileNumber;
+            if (m_fileNumber >= static_cast<std::uint32_t>(MAX_FILES))
+                std::remove(fileName(m_fileNumber - MAX_FILES).c_str());
+            openFile();
+        }
+    }
+
+    bool openFile() {
+        m_file = std::fopen(fileName(m_fileNumber).c_str(), "wb");
+        if (!m_file)
+            return false;
+        std::uint32_t recordSize = sizeof(TelemetryRecord);
+        std::fwrite("BKTL", 1, 4, m_file);
+        std::fwrite(&VERSION, sizeof VERSION, 1, m_file);
+        std::fwrite(&recordSize, sizeof recordSize, 1, m_file);
+        std::fwrite(&m_fileNumber, sizeof m_fileNumber, 1, m_file);
+        std::fwrite(&m_startMs, sizeof m_startMs, 1, m_file);
+        m_fileBytes = 0;
+        return true;
+    }
+
+    std::string fileName(std::uint32_t n) const { return m_path + "." + std::to_string(n); }
+
+    std::unique_ptr<MpscQueue<TelemetryRecord, RING>> m_ring{ new MpscQueue<TelemetryRecord, RING> };
+    alignas(64) std::atomic<std::uint32_t> m_dropped{ 0 };
+    Clock::time_point m_start = Clock::now();
+    std::uint64_t m_startMs = 0;
+
+    // Writer thread only (after open()).
+    std::string m_path;
+    std::FILE *m_file = nullptr;
+    std::uint32_t m_fileNumber = 0;
+    long m_fileBytes = 0;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_quit = false;
+};
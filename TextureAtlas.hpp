@@ -0,0 +1,142 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+//
+// Load-time texture atlas: images are packed into one or a few big pages
+// (shelf packing, tallest first) so that everything drawn from the atlas can
+// share a texture bind and end up in the same SpriteBatch group.
+// Each image gets `padding` pixels around it filled with its own edge pixels,
+// so filtering and sub-pixel positions never sample a neighbour.
+//
+
+// Where an image ended up: the page texture and its pixel rect inside it.
+struct AtlasRegion {
+    const sf::Texture *texture = nullptr;
+    sf::FloatRect rect;
+};
+
+class TextureAtlas {
+public:
+    explicit TextureAtlas(unsigned pageSize = 2048, unsigned padding = 2)
+        : m_pageSize(std::min(pageSize, sf::Texture::getMaximumSize())), m_padding(padding) {}
+
+    // Queues an image for packing and returns its id. Empty images are allowed
+    // and get an empty region.
+    int add(const sf::Image &image) {
+        m_images.push_back(image);
+        m_regions.emplace_back();
+        return static_cast<int>(m_images.size()) - 1;
+    }
+
+    //
+    // Packs every queued image and uploads the pages. Returns false if a page
+    // texture could not be created.
+    //
+    bool build() {
+        std::vector<int> order;
+        for (int i = 0; i < static_cast<int>(m_images.size()); ++i)
+            if (m_images[i].getSize().x > 0 && m_images[i].getSize().y > 0)
+                order.push_back(i);
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            return m_images[a].getSize().y > m_images[b].getSize().y;
+        });
+
+        struct Placement { int image, page; unsigned x, y; };
+        std::vector<Placement> placements;
+        std::vector<sf::Vector2u> pageUsed;  // width/height actually used per page
+        unsigned shelfX = 0, shelfY = 0, shelfH = 0;
+        const unsigned pad2 = 2 * m_padding;
+
+        for (int id : order) {
+            sf::Vector2u s = m_images[id].getSize();
+            unsigned w = s.x + pad2, h = s.y + pad2;
+
+            // Too big for a shared page: give it a page of its own.
+            if (w > m_pageSize || h > m_pageSize) {
+                pageUsed.push_back({ w, h });
+                placements.push_back({ id, static_cast<int>(pageUsed.size()) - 1, 0, 0 });
+                shelfX = shelfY = shelfH = 0;
+                pageUsed.push_back({ 0, 0 });
+                continue;
+            }
+            if (pageUsed.empty())
+                pageUsed.push_back({ 0, 0 });
+            if (shelfX + w > m_pageSize) {       // next shelf
+                shelfY += shelfH;
+                shelfX = shelfH = 0;
+            }
+            if (shelfY + h > m_pageSize) {       // next page
+                pageUsed.push_back({ 0, 0 });
+                shelfX = shelfY = shelfH = 0;
+            }
+            int page = static_cast<int>(pageUsed.size()) - 1;
+            placements.push_back({ id, page, shelfX, shelfY });
+            shelfX += w;
+            shelfH = std::max(shelfH, h);
+            pageUsed[page].x = std::max(pageUsed[page].x, shelfX);
+            pageUsed[page].y = std::max(pageUsed[page].y, shelfY + shelfH);
+        }
+
+        // Compose the page images, then upload them.
+        std::vector<sf::Image> pages(pageUsed.size());
+        for (size_t p = 0; p < pages.size(); ++p)
+            if (pageUsed[p].x > 0)
+                pages[p].create(pageUsed[p].x, pageUsed[p].y, sf::Color::Transparent);
+        for (const Placement &pl : placements)
+            blit(pages[pl.page], m_images[pl.image], pl.x, pl.y);
+
+        m_pages.clear();
+        std::vector<int> pageIndex(pages.size(), -1);
+        for (size_t p = 0; p < pages.size(); ++p) {
+            if (pageUsed[p].x == 0)
+                continue;
+            m_pages.push_back(std::unique_ptr<sf::Texture>(new sf::Texture()));
+            if (!m_pages.back()->loadFromImage(pages[p]))
+                return false;
+            pageIndex[p] = static_cast<int>(m_pages.size()) - 1;
+        }
+        for (const Placement &pl : placements) {
+            sf::Vector2u s = m_images[pl.image].getSize();
+            AtlasRegion &r = m_regions[pl.image];
+            r.texture = m_pages[pageIndex[pl.page]].get();
+            r.rect = sf::FloatRect(static_cast<float>(pl.x + m_padding), static_cast<float>(pl.y + m_padding),
+                                   static_cast<float>(s.x), static_cast<float>(s.y));
+        }
+
+        // The source images are no longer needed.
+        m_images.clear();
+        m_images.shrink_to_fit();
+        return true;
+    }
+
+    const AtlasRegion &region(int id) const { return m_regions[id]; }
+    size_t pageCount() const { return m_pages.size(); }
+
+private:
+    // Copies img into page at (x, y) + padding and extrudes its edges into the padding.
+    void blit(sf::Image &page, const sf::Image &img, unsigned x, unsigned y) const {
+        sf::Vector2u s = img.getSize();
+        page.copy(img, x + m_padding, y + m_padding);
+        for (unsigned p = 0; p < m_padding; ++p) {
+            for (unsigned i = 0; i < s.x; ++i) {
+                page.setPixel(x + m_padding + i, y + p, img.getPixel(i, 0));
+                page.setPixel(x + m_padding + i, y + m_padding + s.y + p, img.getPixel(i, s.y - 1));
+            }
+            for (unsigned j = 0; j < s.y + 2 * m_padding; ++j) {
+                unsigned sj = j < m_padding ? 0 : std::min(j - m_padding, s.y - 1);
+                page.setPixel(x + p, y + j, img.getPixel(0, sj));
+                page.setPixel(x + m_padding + s.x + p, y + j, img.getPixel(s.x - 1, sj));
+            }
+        }
+    }
+
+    unsigned m_pageSize;
+    unsigned m_padding;
+    std::vector<sf::Image> m_images;
+    std::vector<AtlasRegion> m_regions;
+    std::vector<std::unique_ptr<sf::Texture>> m_pages;
+};
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "RaceConfig.hpp"
+#include "RaceRng.hpp"
+
+//
+// One thing placed on the track: it enters the top of the view once the
+// track has scrolled `at` pixels since the start of the race.
+//
+struct TrackItem {
+    float at = 0.f;
+    float u = 0.f;           // trees: horizontal position in [0, 1) on their side of the road
+    std::uint8_t lane = 0;   // obstacles, bottles, coins; trees: 0 left of the road, 1 right
+    std::uint8_t kind = 0;   // texture variant for trees and obstacles
+};
+
+enum TrackItemType { TRACK_TREES, TRACK_OBSTACLES, TRACK_BOTTLES, TRACK_COINS, TRACK_ITEM_TYPES };
+
+//
+// CHUNK_LENGTH pixels of track, one item list per type, each sorted by `at`.
+//
+struct TrackChunk {
+    static const int MAX_ITEMS = 512;  // per type; normal configs place a few dozen, the packed bench scenarios up to ~430
+
+    int index = -1;
+    int count[TRACK_ITEM_TYPES] = {};
+    TrackItem items[TRACK_ITEM_TYPES][MAX_ITEMS];
+};
+
+//
+// The race course, generated from the race seed a chunk at a time, a few
+// chunks ahead of the player, into a fixed ring of chunks: a chunk is
+// overwritten once the player is past it, so memory stays the same however
+// long the race. The course only depends on the seed and the config's
+// rates, lanes and sprite sizes (not on the input or the window size), so
+// the same seed always gives the same course.
+//
+// Obstacles come in rows that never block every lane; one lane is kept
+// free, and it moves by at most one lane from a row to the next so there is
+// always a way through. Spacing along the track comes from the config's
+// rates at defaultSpeed, with the same minimum gaps the per-frame spawner
+// used to enforce (scaled by the config's minGapScale).
+//
+class TrackStream {
+public:
+    static constexpr float CHUNK_LENGTH = 1024.f;
+    static const int CHUNKS_AHEAD = 2;
+    static const int RING = CHUNKS_AHEAD + 2;  // + the current chunk and the one just behind
+
+    void reset(std::uint64_t seed) {
+        m_seed = seed;
+        m_generated = 0;
+        for (TrackChunk &c : m_ring)
+            c.index = -1;
+        for (int t = 0; t < TRACK_ITEM_TYPES; ++t) {
+            m_nextAt[t] = 0.f;
+            m_cursorChunk[t] = 0;
+            m_cursorItem[t] = 0;
+        }
+        m_freeLane = -1;
+        m_overflowed = 0;
+    }
+
+    // Generates every chunk up to CHUNKS_AHEAD past the one holding `pos`.
+    void generateAhead(float pos, const RaceConfig &cfg) {
+        int want = static_cast<int>(pos / CHUNK_LENGTH) + CHUNKS_AHEAD;
+        while (m_generated <= want)
+            generate(m_generated++, cfg);
+    }
+
+    //
+    // Calls f(item) for each item of `type` that has come into view by
+    // `pos` and was not handed out yet, in track order. f returns false to
+    // hold the item back (and everything after it) until a later call; an
+    // item held back until it is a whole chunk behind is dropped.
+    //
+    template <typename F>
+    void release(TrackItemType type, float pos, F f) {
+        while (m_cursorChunk[type] < m_generated) {
+            const TrackChunk &c = m_ring[m_cursorChunk[type] % RING];
+            if (c.index != m_cursorChunk[type] || m_cursorItem[type] == c.count[type]) {
+                ++m_cursorChunk[type];  // done, or already overwritten by a chunk ahead
+                m_cursorItem[type] = 0;
+                continue;
+            }
+            const TrackItem &item = c.items[type][m_cursorItem[type]];
+            if (item.at > pos)
+                return;
+            if (item.at >= pos - CHUNK_LENGTH && !f(item))
+                return;
+            ++m_cursorItem[type];
+        }
+    }
+
+    //
+    // Calls f(item) for each item of `type` not handed out by release() yet
+    // (including any being held back), in track order, up to `upTo`. Only
+    // sees chunks already generated.
+    //
+    template <typename F>
+    void peek(TrackItemType type, float upTo, F f) const {
+        int item = m_cursorItem[type];
+        for (int chunk = m_cursorChunk[type]; chunk < m_generated; ++chunk, item = 0) {
+            const TrackChunk &c = m_ring[chunk % RING];
+            if (c.index != chunk)
+                continue;
+            for (; item < c.count[type]; ++item) {
+                if (c.items[type][item].at > upTo)
+                    return;
+                f(c.items[type][item]);
+            }
+        }
+    }
+
+    int chunksGenerated() const { return m_generated; }
+
+    // Items that did not fit their chunk (MAX_ITEMS) and were left out of
+    // the course since reset(); the rates are too high for the chunk size.
+    int overflowed() const { return m_overflowed; }
+
+    // Writes the generator state and the items of every chunk in the ring to
+    // w (see RaceHistory); load() reads them back.
+    template <typename Writer>
+    void save(Writer &w) const {
+        w(m_seed);
+        w(m_generated);
+        w(m_nextAt, TRACK_ITEM_TYPES);
+        w(m_cursorChunk, TRACK_ITEM_TYPES);
+        w(m_cursorItem, TRACK_ITEM_TYPES);
+        w(m_freeLane);
+        for (const TrackChunk &c : m_ring) {
+            w(c.index);
+            w(c.count, TRACK_ITEM_TYPES);
+            for (int t = 0; t < TRACK_ITEM_TYPES; ++t)
+                w(c.items[t], c.count[t]);
+        }
+    }
+
+    template <typename Reader>
+    void load(Reader &r) {
+        r(m_seed);
+        r(m_generated);
+        r(m_nextAt, TRACK_ITEM_TYPES);
+        r(m_cursorChunk, TRACK_ITEM_TYPES);
+        r(m_cursorItem, TRACK_ITEM_TYPES);
+        r(m_freeLane);
+        for (TrackChunk &c : m_ring) {
+            r(c.index);
+            r(c.count, TRACK_ITEM_TYPES);
+            for (int t = 0; t < TRACK_ITEM_TYPES; ++t)
+                r(c.items[t], c.count[t]);
+        }
+    }
+
+private:
+    // Average distance between items placed at `rate` per second; a type
+    // with no rate gets none at all.
+    float spacing(TrackItemType type, float rate, float defaultSpeed) {
+        if (rate > 0.f)
+            return defaultSpeed / rate;
+        m_nextAt[type] = std::numeric_limits<float>::infinity();
+        return 0.f;
+    }
+
+    void add(TrackChunk &c, TrackItemType type, const TrackItem &item) {
+        if (c.count[type] < TrackChunk::MAX_ITEMS)
+            c.items[type][c.count[type]++] = item;
+        else
+            ++m_overflowed;
+    }
+
+    void generate(int index, const RaceConfig &cfg) {
+        TrackChunk &c = m_ring[index % RING];
+        c.index = index;
+        for (int t = 0; t < TRACK_ITEM_TYPES; ++t)
+            c.count[t] = 0;
+
+        RaceRng rng;
+        rng.reseed(m_seed ^ (static_cast<std::uint64_t>(index) * 0x9e3779b97f4a7c15ULL), 77u);
+        float end = (index + 1) * CHUNK_LENGTH;
+        int lanes = std::max(1, cfg.lanes);
+
+        // Trees, on a random side of the road, at least 200 px apart.
+        float minGap = cfg.minGapScale;
+        float treeGap = spacing(TRACK_TREES, cfg.treeRate, cfg.defaultSpeed);
+        while (m_nextAt[TRACK_TREES] < end) {
+            TrackItem tree;
+            tree.at = m_nextAt[TRACK_TREES];
+            tree.kind = static_cast<std::uint8_t>(rng.below(RaceConfig::TREE_KINDS));
+            tree.lane = static_cast<std::uint8_t>(rng.below(2));
+            tree.u = rng.uniform();
+            add(c, TRACK_TREES, tree);
+            m_nextAt[TRACK_TREES] += (200.f + cfg.trees[tree.kind].h) * minGap + 2.f * treeGap * rng.uniform();
+        }
+
+        // Obstacle rows: one or (now and then) two lanes blocked, never the free
+        // one. A single-lane road gets no obstacles, it could not be dodged.
+        float rowGap = spacing(TRACK_OBSTACLES, lanes > 1 ? cfg.obstacleRate : 0.f, cfg.defaultSpeed);
+        float tallest = 0.f;
+        for (const SpriteSize &o : cfg.obstacles)
+            tallest = std::max(tallest, o.h * cfg.obstacleScale);
+        while (m_nextAt[TRACK_OBSTACLES] < end) {
+            if (m_freeLane < 0 || m_freeLane >= lanes)
+                m_freeLane = rng.below(lanes);
+            else
+                m_freeLane = std::max(0, std::min(lanes - 1, m_freeLane + rng.below(3) - 1));
+            int blocked = std::min(lanes - 1, rng.below(4) == 0 ? 2 : 1);
+            int first = rng.below(lanes - 1);
+            for (int b = 0; b < blocked; ++b) {
+                // distinct lanes among the lanes - 1 others, wrapping past the free one
+                int lane = (m_freeLane + 1 + (first + b) % (lanes - 1)) % lanes;
+                TrackItem obstacle;
+                obstacle.at = m_nextAt[TRACK_OBSTACLES];
+                obstacle.lane = static_cast<std::uint8_t>(lane);
+                obstacle.kind = static_cast<std::uint8_t>(rng.below(RaceConfig::OBSTACLE_KINDS));
+                add(c, TRACK_OBSTACLES, obstacle);
+            }
+            m_nextAt[TRACK_OBSTACLES] += (150.f + tallest) * minGap + 2.f * rowGap * rng.uniform();
+        }
+
+        // Collectibles, at least 100 px apart from their own kind.
+        const TrackItemType collectibles[] = { TRACK_BOTTLES, TRACK_COINS };
+        const float rates[] = { cfg.bottleRate, cfg.coinRate };
+        for (int k = 0; k < 2; ++k) {
+            TrackItemType type = collectibles[k];
+            float gap = spacing(type, rates[k], cfg.defaultSpeed);
+            while (m_nextAt[type] < end) {
+                TrackItem item;
+                item.at = m_nextAt[type];
+                item.lane = static_cast<std::uint8_t>(rng.below(lanes));
+                add(c, type, item);
+                m_nextAt[type] += 100.f * minGap + 2.f * gap * rng.uniform();
+            }
+        }
+    }
+
+    std::uint64_t m_seed = 0;
+    int m_generated = 0;  // chunks [0, m_generated) exist or existed
+    TrackChunk m_ring[RING];
+    float m_nextAt[TRACK_ITEM_TYPES] = {};  // where each type's next item goes
+    int m_cursorChunk[TRACK_ITEM_TYPES] = {};  // next item to release, per type
+    int m_cursorItem[TRACK_ITEM_TYPES] = {};
+    int m_freeLane = -1;
+    int m_overflowed = 0;
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "SpriteBatch.hpp"
+#include "TextureAtlas.hpp"
+
+//
+// Prebaked glyphs of one font: every Latin-1 character at each character size
+// the UI uses, rasterized once by sf::Font and packed into a TextureAtlas, so
+// all UI text shares one texture and goes through the SpriteBatch in a single
+// draw call. Characters outside Latin-1 are drawn as '?'.
+//
+class GlyphAtlas {
+public:
+    struct Glyph {
+        float advance = 0.f;
+        sf::FloatRect bounds;  // quad relative to the pen position on the baseline
+        AtlasRegion region;    // empty for blank characters (space)
+    };
+
+    bool build(const sf::Font &font, const std::vector<unsigned> &sizes) {
+        m_font = &font;
+        m_sizes = sizes;
+        m_glyphs.assign(sizes.size() * 256, Glyph());
+        std::vector<int> ids(m_glyphs.size(), -1);
+        for (size_t s = 0; s < sizes.size(); ++s) {
+            // Rasterize the whole set first so the font page is final, then read it back once.
+            for (unsigned c = 0; c < 256; ++c)
+                if (isBaked(c))
+                    font.getGlyph(c, sizes[s], false);
+            sf::Image page = font.getTexture(sizes[s]).copyToImage();
+            for (unsigned c = 0; c < 256; ++c) {
+                if (!isBaked(c))
+                    continue;
+                const sf::Glyph &g = font.getGlyph(c, sizes[s], false);
+                Glyph &out = m_glyphs[s * 256 + c];
+                out.advance = g.advance;
+                out.bounds = g.bounds;
+                if (g.textureRect.width <= 0 || g.textureRect.height <= 0)
+                    continue;
+                sf::Image img;
+                img.create(g.textureRect.width, g.textureRect.height, sf::Color::Transparent);
+                img.copy(page, 0, 0, g.textureRect);
+                ids[s * 256 + c] = m_atlas.add(img);
+            }
+        }
+        if (!m_atlas.build())
+            return false;
+        for (size_t i = 0; i < ids.size(); ++i)
+            if (ids[i] >= 0)
+                m_glyphs[i].region = m_atlas.region(ids[i]);
+        return true;
+    }
+
+    // Glyph of codepoint c at a baked size (falls back to the nearest baked size).
+    const Glyph &glyph(sf::Uint32 c, unsigned size) const {
+        if (c >= 256 || !isBaked(c))
+            c = '?';
+        return m_glyphs[sizeIndex(size) * 256 + c];
+    }
+
+    float lineSpacing(unsigned size) const { return m_font->getLineSpacing(m_sizes[sizeIndex(size)]); }
+    float kerning(sf::Uint32 a, sf::Uint32 b, unsigned size) const { return m_font->getKerning(a, b, m_sizes[sizeIndex(size)]); }
+
+private:
+    static bool isBaked(unsigned c) { return (c >= 32 && c < 127) || c >= 160; }
+
+    size_t sizeIndex(unsigned size) const {
+        size_t best = 0;
+        for (size_t i = 1; i < m_sizes.size(); ++i)
+            if (std::abs(static_cast<int>(m_sizes[i]) - static_cast<int>(size)) <
+                std::abs(static_cast<int>(m_sizes[best]) - static_cast<int>(size)))
+                best = i;
+        return best;
+    }
+
+    const sf::Font *m_font = nullptr;
+    std::vector<unsigned> m_sizes;
+    std::vector<Glyph> m_glyphs;  // 256 per size
+    TextureAtlas m_atlas{ 2048, 1 };
+};
+
+//
+// Retained UI string drawn from a GlyphAtlas. The glyph layout (one quad per
+// character, laid out like sf::Text) is only redone when the string or the
+// character size actually changes; drawing just copies the quads into the
+// SpriteBatch at a position and color, so pulsing, moving and shadowed text
+// cost no relayout.
+//
+class UiText {
+public:
+    UiText() = default;
+    UiText(const GlyphAtlas &atlas, unsigned size, const std::string &utf8 = std::string())
+        : m_atlas(&atlas), m_string(utf8), m_size(size) {}
+
+    void setString(const std::string &utf8) {
+        if (utf8 != m_string) {
+            m_string = utf8;
+            m_dirty = true;
+        }
+    }
+
+    void setCharacterSize(unsigned size) {
+        if (size != m_size) {
+            m_size = size;
+            m_dirty = true;
+        }
+    }
+
+    const std::string &getString() const { return m_string; }
+    unsigned getCharacterSize() const { return m_size; }
+
+    // Same meaning as sf::Text::getLocalBounds.
+    sf::FloatRect getLocalBounds() const {
+        layout();
+        return m_bounds;
+    }
+
+    // Queues the text with its origin at (x, y).
+    void draw(SpriteBatch &batch, float x, float y, const sf::Color &color = sf::Color::White,
+              BatchLayer layer = LAYER_TEXT) const {
+        layout();
+        for (const Quad &q : m_quads)
+            batch.add(layer, q.region.texture, q.region.rect, x + q.x, y + q.y, 1.f, 1.f, color);
+    }
+
+private:
+    struct Quad {
+        AtlasRegion region;
+        float x, y;
+    };
+
+    void layout() const {
+        if (!m_dirty || !m_atlas)
+            return;
+        m_dirty = false;
+        m_quads.clear();
+        sf::String text = sf::String::fromUtf8(m_string.begin(), m_string.end());
+        float lineSpacing = m_atlas->lineSpacing(m_size);
+        float penX = 0.f, penY = static_cast<float>(m_size);
+        float minX = static_cast<float>(m_size), minY = static_cast<float>(m_size), maxX = 0.f, maxY = 0.f;
+        sf::Uint32 prev = 0;
+        for (std::size_t i = 0; i < text.getSize(); ++i) {
+            sf::Uint32 c = text[i];
+            penX += m_atlas->kerning(prev, c, m_size);
+            prev = c;
+            if (c == '\n') {
+                penX = 0.f;
+                penY += lineSpacing;
+                continue;
+            }
+            const GlyphAtlas::Glyph &g = m_atlas->glyph(c == '\t' ? ' ' : c, m_size);
+            if (g.region.texture) {
+                m_quads.push_back(Quad{ g.region, penX + g.bounds.left, penY + g.bounds.top });
+                minX = std::min(minX, penX + g.bounds.left);
+                minY = std::min(minY, penY + g.bounds.top);
+                maxX = std::max(maxX, penX + g.bounds.left + g.bounds.width);
+                maxY = std::max(maxY, penY + g.bounds.top + g.bounds.height);
+            }
+            penX += c == '\t' ? 4.f * g.advance : g.advance;
+        }
+        m_bounds = m_quads.empty() ? sf::FloatRect() : sf::FloatRect(minX, minY, maxX - minX, maxY - minY);
+    }
+
+    const GlyphAtlas *m_atlas = nullptr;
+    std::string m_string;
+    unsigned m_size = 30;
+    mutable bool m_dirty = true;
+    mutable std::vector<Quad> m_quads;
+    mutable sf::FloatRect m_bounds;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <cstdint>
+
+// Which effects win when every voice is busy.
+enum SoundPriority {
+    PRIORITY_LOW,     // pickups: fine to cut short
+    PRIORITY_NORMAL,  // UI clicks, tired
+    PRIORITY_HIGH,    // crash, finish: never dropped for a lower one
+};
+
+//
+// Fixed set of sf::Sound voices created once at startup, shared by every
+// sound effect. play() takes a free voice; when all of them are busy it
+// steals the least important one (lowest priority, then quietest, then the
+// one that has been playing longest) or drops the new sound if everything
+// playing matters more. Effects can therefore overlap (two coins in a row
+// both sound), and the game never uses more than MAX_VOICES OpenAL sources
+// for effects however many play at once. The buffers are the decoded ones
+// kept in memory by the loader; a voice only points at them.
+//
+class VoicePool {
+public:
+    static const int MAX_VOICES = 16;
+
+    // Starts buffer on a voice. Returns false if it was dropped.
+    bool play(const sf::SoundBuffer &buffer, SoundPriority priority, float volume = 100.f) {
+        int v = pickVoice(priority, volume);
+        if (v < 0)
+            return false;
+        Voice &voice = m_voices[v];
+        voice.sound.stop();
+        voice.sound.setBuffer(buffer);
+        voice.sound.setVolume(volume);
+        voice.sound.play();
+        voice.priority = priority;
+        voice.volume = volume;
+        voice.started = ++m_clock;
+        return true;
+    }
+
+    void stopAll() {
+        for (Voice &voice : m_voices)
+            voice.sound.stop();
+    }
+
+    int playing() const {
+        int n = 0;
+        for (const Voice &voice : m_voices)
+            n += voice.sound.getStatus() == sf::Sound::Playing;
+        return n;
+    }
+
+private:
+    struct Voice {
+        sf::Sound sound;
+        SoundPriority priority = PRIORITY_LOW;
+        float volume = 0.f;
+        std::uint64_t started = 0;  // play() count when it started
+    };
+
+    int pickVoice(SoundPriority priority, float volume) const {
+        int best = -1;
+        for (int i = 0; i < MAX_VOICES; ++i) {
+            const Voice &voice = m_voices[i];
+            if (voice.sound.getStatus() != sf::Sound::Playing)
+                return i;
+            if (voice.priority > priority || (voice.priority == priority && voice.volume > volume))
+                continue;  // more important than the new sound
+            if (best < 0 || lessImportant(voice, m_voices[best]))
+                best = i;
+        }
+        return best;
+    }
+
+    static bool lessImportant(const Voice &a, const Voice &b) {
+        if (a.priority != b.priority)
+            return a.priority < b.priority;
+        if (a.volume != b.volume)
+            return a.volume < b.volume;
+        return a.started < b.started;
+    }
+
+    Voice m_voices[MAX_VOICES];
+    std::uint64_t m_clock = 0;
+};
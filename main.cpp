@@ -1,1002 +1,1380 @@
-#include <SFML/Graphics.hpp>
-#include <SFML/Audio.hpp>
-#include <iostream>
-#include <cmath>
-#include <vector>
-#include <cstdlib>
-#include <ctime>
-
-// Game states
-enum GameState { MENU, APROPOS, LOADING, GAME, HIT, FINISH };
-
-//
-// Helper: Resets the player sprite position based on the lane.
-//
-void resetPlayer(sf::Sprite &player, const sf::Texture &roadTexture, int playerLane,
-                 float padLeft, float padRight, int LANES, const sf::RenderWindow &window)
-{
-    float rw = static_cast<float>(roadTexture.getSize().x);
-    float roadLeft = (window.getSize().x - rw) / 2.f;
-    float leftPad = padLeft * rw;
-    float inner = rw - (padLeft + padRight) * rw;
-    float laneW = inner / LANES;
-    float pw = player.getGlobalBounds().width;
-    float playerTargetX = roadLeft + leftPad + laneW * (playerLane + 0.5f) - pw / 2.f;
-    float py = window.getSize().y - player.getGlobalBounds().height - 10.f;
-    player.setPosition(playerTargetX, py);
-}
-
-//
-// Helper: Spawns a bottle if it does not overlap obstacles or coins.
-// Adjust the bottle's size with setScale below.
-//
-void spawnBottle(std::vector<sf::Sprite>& bottles, const sf::Texture &bottleTex,
-                 float roadTextureWidth, float padLeft, float padRight, int LANES,
-                 sf::RenderWindow &window, const std::vector<sf::Sprite>& obstacles,
-                 const std::vector<sf::Sprite>& coins)
-{
-    if (std::rand() % 1000 < 5)
-    {
-        int lane = std::rand() % LANES;
-        sf::Sprite b(bottleTex);
-        b.setScale(0.23f, 0.23f);  // Adjust bottle size as needed.
-        float rw = roadTextureWidth;
-        float roadL = (window.getSize().x - rw) / 2.f;
-        float lp = padLeft * rw;
-        float inner = rw - (padLeft + padRight) * rw;
-        float laneW = inner / LANES;
-        float bx = roadL + lp + laneW * (lane + 0.5f) - b.getGlobalBounds().width / 2.f;
-        float by = -b.getGlobalBounds().height - (std::rand() % 100);
-        b.setPosition(bx, by);
-        for (const auto &existingBottle : bottles) {
-            if (std::abs(existingBottle.getPosition().y - b.getPosition().y) < 100.f)
-                return;
-        }
-        for (const auto &obs : obstacles) {
-            if (b.getGlobalBounds().intersects(obs.getGlobalBounds()))
-                return;
-        }
-        for (const auto &coin : coins) {
-            if (b.getGlobalBounds().intersects(coin.getGlobalBounds()))
-                return;
-        }
-        bottles.push_back(b);
-    }
-}
-
-//
-// Helper: Spawns a coin collectible (score item) if it does not overlap obstacles, bottles, or coins.
-// The coin's size is controlled here with c.setScale(0.16f, 0.16f).
-//
-void spawnScoreCoin(std::vector<sf::Sprite>& coins, const sf::Texture &coinTex,
-                    float roadTextureWidth, float padLeft, float padRight, int LANES,
-                    sf::RenderWindow &window, const std::vector<sf::Sprite>& obstacles,
-                    const std::vector<sf::Sprite>& bottles) {
-    if (std::rand() % 1000 < 4) {
-        int lane = std::rand() % LANES;
-        sf::Sprite c(coinTex);
-        c.setScale(0.16f, 0.16f);  // Control the coin's size here.
-        float rw = roadTextureWidth;
-        float roadL = (window.getSize().x - rw) / 2.f;
-        float lp = padLeft * rw;
-        float inner = rw - (padLeft + padRight) * rw;
-        float laneW = inner / LANES;
-        float cx = roadL + lp + laneW * (lane + 0.5f) - c.getGlobalBounds().width / 2.f;
-        float cy = -c.getGlobalBounds().height - (std::rand() % 150);
-        c.setPosition(cx, cy);
-        for (const auto &existingCoin : coins) {
-            if (std::abs(existingCoin.getPosition().y - c.getPosition().y) < 100.f)
-                return;
-        }
-        for (const auto &obs : obstacles) {
-            if (c.getGlobalBounds().intersects(obs.getGlobalBounds()))
-                return;
-        }
-        for (const auto &bottle : bottles) {
-            if (c.getGlobalBounds().intersects(bottle.getGlobalBounds()))
-                return;
-        }
-        coins.push_back(c);
-    }
-}
-
-//
-// Helper: Updates bottles movement and handles player collection.
-// When collected, increases stamina and plays the drink sound.
-void updateBottles(std::vector<sf::Sprite>& bottles, float worldSpeed, sf::RenderWindow &window,
-                   sf::Sprite &player, float &stamina, const float MAX_STAMINA,
-                   const float BOTTLE_STAMINA, sf::Sound &drinkSound) {
-    for (auto it = bottles.begin(); it != bottles.end(); ) {
-        it->move(0, worldSpeed);
-        if (player.getGlobalBounds().intersects(it->getGlobalBounds())) {
-            drinkSound.play();
-            stamina = std::min(MAX_STAMINA, stamina + BOTTLE_STAMINA);
-            it = bottles.erase(it);
-        } else if (it->getPosition().y > window.getSize().y) {
-            it = bottles.erase(it);
-        } else {
-            window.draw(*it);
-            ++it;
-        }
-    }
-}
-
-//
-// Helper: Updates coin collectibles movement and handles player collection.
-// When collected, increases the score by 100 and plays a coin sound.
-void updateCoins(std::vector<sf::Sprite>& coins, float worldSpeed, sf::RenderWindow &window,
-                 sf::Sprite &player, int &score, sf::Sound &coinSound) {
-    for (auto it = coins.begin(); it != coins.end(); ) {
-        it->move(0, worldSpeed);
-        if (player.getGlobalBounds().intersects(it->getGlobalBounds())) {
-            coinSound.play();
-            score += 100;
-            it = coins.erase(it);
-        } else if (it->getPosition().y > window.getSize().y) {
-            it = coins.erase(it);
-        } else {
-            window.draw(*it);
-            ++it;
-        }
-    }
-}
-
-//
-// Main function with game loop and helper functions.
-//
-int main() {
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
-
-    sf::RenderWindow window(sf::VideoMode(800, 600), "Bike Game", sf::Style::Default);
-    window.setFramerateLimit(60);
-    
-    GameState gameState = MENU;
-
-    // — ASSETS —
-    sf::Font font;
-    if (!font.loadFromFile("resources/fonts/Pixelite.ttf")) {
-        std::cerr << "Failed to load font\n";
-        return -1;
-    }
-    
-    sf::Texture finishLineTexture;
-    if (!finishLineTexture.loadFromFile("resources/images/finish.png")) {
-        std::cerr << "Failed to load finish line texture\n";
-        // Gérer l'erreur ici
-    }
-
-    sf::Texture bgTexture;
-    if (!bgTexture.loadFromFile("resources/images/bgmenu.jpg")) {
-        std::cerr << "Failed to load bgmenu.jpg\n";
-        return -1;
-    }
-    sf::Sprite bgSprite(bgTexture);
-    
-    sf::Music bgMusic;
-    if (bgMusic.openFromFile("resources/audios/bgmenu.ogg")) {
-        bgMusic.setLoop(true);
-        bgMusic.setVolume(25.f);
-        bgMusic.play();
-    }
-    
-    sf::SoundBuffer clickBuf, crashBuf, drinkBuf, coinBuf, finishBuf, tiredBuf;
-    if (!clickBuf.loadFromFile("resources/audios/click.wav") ||
-        !crashBuf.loadFromFile("resources/audios/crash.wav") ||
-        !drinkBuf.loadFromFile("resources/audios/drink.wav") ||
-        !coinBuf.loadFromFile("resources/audios/coin.wav") ||
-        !tiredBuf.loadFromFile("resources/audios/tired.wav") ||
-        !finishBuf.loadFromFile("resources/audios/finish.wav"))
-    {
-        std::cerr << "Failed to load one or more sound files\n";
-        return -1;
-    }
-
-    sf::Sound clickSound(clickBuf), crashSound(crashBuf), drinkSound(drinkBuf), coinSound(coinBuf), finishSound(finishBuf), tiredSound(tiredBuf);
-    
-    sf::Texture roadTexture;
-    if (!roadTexture.loadFromFile("resources/images/road.png")) {
-        std::cerr << "Failed to load road texture\n";
-        return -1;
-    }
-    // --- MOD 2 - ADD THESE LINES ---
-    sf::Sprite finishLine;          // Separate finish line sprite
-    const float TILE_H       = static_cast<float>(roadTexture.getSize().y);
-    const int   NUM_TILES    = 10;
-    const float RACE_DISTANCE = TILE_H * NUM_TILES;
-    bool finishLineSpawned = false; // Control finish line appearance
-    bool raceFinished = false;      // Prevent duplicate triggers
-    float FINISH_SPAWN_AT = RACE_DISTANCE - 500.f; // Adjust as needed
-    bool finishTriggered = false;
-    sf::Clock finishTriggerClock;
-    // how many seconds to wait after crossing the line before showing “FÉLICITATIONS!”
-    const float FINISH_DELAY = 2.0f;
-
-
-
-    // — MENU TEXTS —
-    std::string labels[4] = {"Jouer", "A propos", "Quitter", "RETOUR"};
-    sf::Text menu[4], shadow[4];
-    for (int i = 0; i < 4; ++i) {
-        menu[i].setFont(font);
-        menu[i].setString(labels[i]);
-        menu[i].setCharacterSize(32);
-        menu[i].setFillColor(sf::Color::White);
-        shadow[i] = menu[i];
-        shadow[i].setFillColor(sf::Color::Black);
-    }
-    int selected = 0;
-
-    sf::Text staminaLabel;
-    staminaLabel.setFont(font);
-    staminaLabel.setCharacterSize(24);
-    staminaLabel.setFillColor(sf::Color::White);
-    
-    // Put each letter on its own line:
-    staminaLabel.setString("S\nT\nA\nM\nI\nN\nA");
-    // Optional: adjust line spacing if needed
-    staminaLabel.setLineSpacing(1.0f);
-    
-
-    sf::Text positionLabel;
-    positionLabel.setFont(font);
-    positionLabel.setCharacterSize(24);
-    positionLabel.setFillColor(sf::Color::White);
-    positionLabel.setString("VOTRE POSITION :");
-
-    // after loading font…
-    sf::Text finishTitle("", font, 64);
-    finishTitle.setFillColor(sf::Color::Yellow);
-
-    sf::Text finishScore("", font, 32);
-    finishScore.setFillColor(sf::Color::White);
-
-    sf::Text returnBtn("RETOUR AU MENU", font, 28);
-    returnBtn.setFillColor(sf::Color::White);
-
-    
-    // — “A PROPOS” SCROLLING TEXT —
-    std::vector<std::vector<std::string>> aproposTexts = {{
-        "Bienvenue dans notre projet de mini-jeu de velo",
-        "Realise par Mahmoud Moukouch & Mohamed Lakhdar",
-        "Encadre par Professeur Rachida Hannane",
-        "Dans notre filiere IAPS4 a l'Universite FSSM Marrakech",
-        "Ce jeu est conçu pour offrir une experience immersive",
-        "Avec des graphismes futuristes et un gameplay dynamique",
-        "Le but est de collecter des objets tout en evitant des obstacles",
-        "- Collecte de bouteilles pour gagner des points",
-        "- Evitez les autres velos sur la route",
-        "- Profitez de l'adrenaline d'une course a grande vitesse",
-        "- Compteur de score pour suivre vos progres",
-        "- Limite de temps pour rendre le defi encore plus excitant",
-        "Nous esperons que vous apprecierez ce jeu innovant!",
-        "Merci de jouer et bonne chance!"
-    }};
-    sf::Text aproposText("", font, 28), aproposShadow("", font, 28);
-    aproposText.setFillColor(sf::Color::White);
-    aproposShadow.setFillColor(sf::Color::Black);
-    size_t currentTextIndex = 0;
-    
-    // — CLOCKS —
-    sf::Clock clock;               // For pulsing alpha
-    sf::Clock aproposScrollClock;  // For "A Propos" scrolling
-    sf::Clock loadingClock;        // For loading screen
-    sf::Clock fadeClock;           // For hit blink effect
-    sf::Clock deltaClock;          // For frame-rate independent dt
-    
-    // — GAME ASSETS & STATE —
-    sf::Texture playerTexture, grassTexture;
-    std::vector<sf::Texture> treeTextures(5), eplayerTextures(5);
-    sf::Texture bottleTex, coinTex;
-    bool assetsLoaded = false;
-    
-    std::vector<sf::Sprite> roadTiles;
-    std::vector<sf::Sprite> trees;
-    std::vector<sf::Sprite> obstacles;
-    std::vector<sf::Sprite> bottles;
-    std::vector<sf::Sprite> coins;
-    
-    sf::Sprite player;
-    int lives = 3, score = 0;
-
-    // Variables pour la course
-    
-    
-    // — STAMINA & COLLECTIBLE PARAMETERS —
-    const float MAX_STAMINA = 5.f;
-    float stamina = MAX_STAMINA;
-    const float STAMINA_DRAIN = 3.f;
-    const float STAMINA_REGEN = 0.5f;
-    const float BOTTLE_STAMINA = 1.f;
-    const float MIN_STAMINA_TO_BOOST = 0.5f;    // you can tweak this (0.5 stamina units)
-
-    // — MOVEMENT & SPEED PARAMETERS —
-    const float DEFAULT_SPEED = 4.f, MAX_SPEED = 12.f;
-    const float ACCEL = 0.2f, BRAKE_FORCE = 0.5f;
-    // Separate speeds: one for your world and one for obstacles.
-    float playerWorldSpeed = DEFAULT_SPEED;  
-    const float obstacleSpeed = DEFAULT_SPEED;
-    
-    // — LANE & ROAD GEOMETRY —
-    const float padLeft = 0.15f, padRight = 0.15f;
-    const int LANES = 4;
-    int playerLane = 1;
-    float grassOffset = 0.f;
-    int roadTileCount = 0;  // how many road sprites to cover the window
-    float tileH = 0.f;  // will be set once roadTexture is loaded
-
-    auto rebuildRoad = [&](sf::RenderWindow &win, std::vector<sf::Sprite> &roadTiles,const sf::Texture &roadTexture,int &roadTileCount,float &tileH)
-    {
-    // compute strip height
-    tileH = static_cast<float>(roadTexture.getSize().y);
-    float winH = static_cast<float>(win.getSize().y);
-    roadTileCount = static_cast<int>(std::ceil(winH / tileH)) + 1;
-    float startY = winH - roadTileCount * tileH;
-    
-    roadTiles.clear();
-    for (int i = 0; i < roadTileCount; ++i) {
-    sf::Sprite tile(roadTexture);
-    tile.setPosition(0.f, startY + i * tileH);
-    roadTiles.push_back(tile);
-    }
-    };
-
-    if (!assetsLoaded)
-    {
-        // — Load & prepare textures —
-        roadTexture.loadFromFile("resources/images/road.png");
-        playerTexture.loadFromFile("resources/images/player.png");
-        grassTexture.loadFromFile("resources/images/grass.png");
-        grassTexture.setRepeated(true);
-        roadTexture.setRepeated(true);
-    
-        // — LOAD ENVIRONMENT SPRITES (trees) —
-        for (int i = 1; i < 5; ++i)
-        {
-            std::string treePath = "resources/images/trees/tree" + std::to_string(i) + ".png";
-            if (!treeTextures[i].loadFromFile(treePath))
-            {
-                std::cerr << "Failed to load " << treePath << "\n";
-                return -1;
-            }
-        }
-    
-        // — LOAD OBSTACLES (eplayers) —
-        for (int i = 0; i < 5; ++i) {
-            std::string eplPath = "resources/images/obstacles/eplayer" + std::to_string(i+1) + ".png";
-            if (!eplayerTextures[i].loadFromFile(eplPath))
-            {
-                std::cerr << "Failed to load " << eplPath << "\n";
-                return -1;
-            }
-        }
-    
-        // — LOAD COLLECTIBLES (bottle and score coins) —
-        if (!bottleTex.loadFromFile("resources/images/coins/bottle.png"))
-        {
-            std::cerr << "Failed to load resources/images/coins/bottle.png\n";
-            return -1;
-        }
-        if (!coinTex.loadFromFile("resources/images/coins/score.png"))
-        {
-            std::cerr << "Failed to load resources/images/coins/score.png\n";
-            return -1;
-        }
-    
-        // — Compute tile height & count AFTER loading —
-        tileH = static_cast<float>(roadTexture.getSize().y);
-        float winH  = static_cast<float>(window.getSize().y);
-        roadTileCount = static_cast<int>(std::ceil(winH / tileH)) + 1;
-    
-        // — Stack the road sprites so bottom is covered immediately —
-        float startY = winH - roadTileCount * tileH;
-        roadTiles.clear();
-        for (int i = 0; i < roadTileCount; ++i)
-        {
-            sf::Sprite tile(roadTexture);
-            tile.setPosition(0.f, startY + i * tileH);
-            roadTiles.push_back(tile);
-        }
-    
-        // — Prepare finish line sprite —
-        float scale = float(roadTexture.getSize().x) / finishLineTexture.getSize().x;
-        finishLine.setTexture(finishLineTexture);
-        finishLine.setScale(scale, scale);
-        finishLine.setPosition(0, -NUM_TILES * TILE_H);
-    
-        // — Player setup, etc. —
-        player.setTexture(playerTexture);
-        player.setScale(0.25f, 0.25f);
-    
-        assetsLoaded = true;
-    }
-    
-    // — GAME LOOP —
-    float       distanceTraveled = 0.f;                         // your progress counter
-
-
-    sf::Sprite playerShadow(player);
-    playerShadow.setScale(0.20f, 0.20f);
-    playerShadow.setColor(sf::Color(0, 0, 0, 150));
-    resetPlayer(player, roadTexture, playerLane, padLeft, padRight, LANES, window);
-    
-    while (window.isOpen())
-    {
-        float dt = deltaClock.restart().asSeconds();
-        // — inside your main loop —  
-        sf::Event ev;
-        while (window.pollEvent(ev))
-        {
-            // 1) Handle window close
-            if (ev.type == sf::Event::Closed)
-            {    window.close();
-            // 2) Handle resize
-            }
-            else if (ev.type == sf::Event::Resized) {
-        // adjust view to new window size
-        sf::FloatRect visibleArea(0, 0, ev.size.width, ev.size.height);
-        window.setView(sf::View(visibleArea));
-
-        // reposition the player in its lane
-        resetPlayer(player, roadTexture, playerLane, padLeft, padRight, LANES, window);
-
-        // rebuild the vertical stack of road tiles
-        rebuildRoad(window, roadTiles, roadTexture, roadTileCount, tileH);
-    }
-    // 3) Keyboard input
-    else if (ev.type == sf::Event::KeyPressed) {
-        if (gameState == MENU) {
-            if (ev.key.code == sf::Keyboard::Up)
-                selected = (selected + 2) % 3;
-            else if (ev.key.code == sf::Keyboard::Down)
-                selected = (selected + 1) % 3;
-            else if (ev.key.code == sf::Keyboard::Enter) {
-                clickSound.play();
-                if (selected == 0) {
-                    // Reset everything so the race truly restarts
-                    finishLineSpawned = false;
-                    raceFinished      = false;
-                    finishTriggered   = false;
-                    // Optionally restart the clock now or rely on the next trigger:
-                    // finishTriggerClock.restart();
-        
-                    gameState = LOADING;
-                    loadingClock.restart();
-                }
-                else if (selected == 1) {
-                    gameState = APROPOS;
-                    aproposScrollClock.restart();
-                    currentTextIndex = 0;
-                }
-                else if (selected == 2) {
-                    window.close();
-                }
-            }
-        }
-        
-        else if (gameState == APROPOS) {
-            if (ev.key.code == sf::Keyboard::Enter) {
-                clickSound.play();
-                gameState = MENU;
-                selected = 0;
-            }
-        }
-        else if (gameState == GAME || gameState == HIT) {
-            if ((ev.key.code == sf::Keyboard::A || ev.key.code == sf::Keyboard::Left) && playerLane > 0) {
-                playerLane--;
-                resetPlayer(player, roadTexture, playerLane, padLeft, padRight, LANES, window);
-            }
-            else if ((ev.key.code == sf::Keyboard::D || ev.key.code == sf::Keyboard::Right) && playerLane < LANES - 1) {
-                playerLane++;
-                resetPlayer(player, roadTexture, playerLane, padLeft, padRight, LANES, window);
-            }
-        }
-    }
-    // you can add other event types (mouse clicks, etc.) here as else if …
-} // End of event polling
-
-    
-        // Clear the window at the beginning of each frame.
-        window.clear();
-    
-        // RESCALE the background each frame.
-        {
-            sf::FloatRect bgBounds = bgSprite.getLocalBounds();
-            float scaleX = window.getSize().x / bgBounds.width;
-            float scaleY = window.getSize().y / bgBounds.height;
-            float scale = std::max(scaleX, scaleY);
-            bgSprite.setScale(scale, scale);
-        }
-    
-        // Get a pulsating alpha value for menus.
-        float time = clock.getElapsedTime().asSeconds();
-        int alpha = static_cast<int>(127.5f * (std::sin(time * 2 * 3.1415f) + 1));
-    
-        // --- STATE HANDLING ---
-    
-        // LOADING STATE:
-        if (gameState == LOADING) {
-            // Display a simple loading screen.
-            sf::RectangleShape blk({ static_cast<float>(window.getSize().x), static_cast<float>(window.getSize().y) });
-            blk.setFillColor(sf::Color::Black);
-            window.draw(blk);
-            sf::Text txt("Chargement en cours...", font, 30);
-            txt.setFillColor(sf::Color(255, 255, 0, alpha));
-            txt.setPosition(window.getSize().x/2.f - txt.getGlobalBounds().width/2.f,
-                            window.getSize().y/2.f);
-            window.draw(txt);
-            window.display();
-            float lt = loadingClock.getElapsedTime().asSeconds();
-            if (lt > 3.f) {
-                // Reset game state variables.
-                lives = 3;
-                score = 0;
-                finishLineSpawned = false;
-                raceFinished = false;
-                finishTriggered = false;
-                trees.clear();
-                obstacles.clear();
-                bottles.clear();
-                coins.clear();
-                playerLane = 1;
-                playerWorldSpeed = DEFAULT_SPEED;
-                stamina = MAX_STAMINA;
-                resetPlayer(player, roadTexture, playerLane, padLeft, padRight, LANES, window);
-                fadeClock.restart();
-                gameState = GAME;
-            }
-            continue; // Skip the rest of the frame.
-        }
-        
-        // MENU STATE:
-        if (gameState == MENU) {
-            // Draw the background.
-            window.draw(bgSprite);
-            // Render the 3 menu items.
-            float centerX = window.getSize().x / 2.f;
-            float startY = window.getSize().y / 2.f - 80.f;
-            for (int i = 0; i < 3; ++i) {
-                sf::FloatRect bounds = menu[i].getLocalBounds();
-                float x = centerX - (bounds.width / 2.f + bounds.left);
-                float y = startY + i * 60.f - bounds.top;
-                shadow[i].setPosition(x + 2, y + 2);
-                menu[i].setPosition(x, y);
-                if (i == selected) {
-                    menu[i].setFillColor(sf::Color(255, 255, 0, alpha));
-                    shadow[i].setFillColor(sf::Color(0, 0, 0, alpha));
-                } else {
-                    menu[i].setFillColor(sf::Color::White);
-                    shadow[i].setFillColor(sf::Color::Black);
-                }
-                window.draw(shadow[i]);
-                window.draw(menu[i]);
-            }
-            window.display();
-            continue; // Skip further game processing.
-        }
-        
-        // APROPOS STATE (About Screen):
-        else if (gameState == APROPOS) {
-            // Draw background.
-            window.draw(bgSprite);
-            
-            // Scroll the about text upward.
-            // (Assumes aproposTexts is a vector of vector of strings; currentTextIndex indexes the current page.)
-            float scrollY = window.getSize().y + 40.f - aproposScrollClock.getElapsedTime().asSeconds() * 60.f;
-            float cx = window.getSize().x / 2.f;
-            for (size_t i = 0; i < aproposTexts[currentTextIndex].size(); ++i) {
-                aproposText.setString(aproposTexts[currentTextIndex][i]);
-                float px = cx - aproposText.getGlobalBounds().width / 2.f;
-                float py = scrollY + i * 40.f;
-                aproposShadow.setString(aproposTexts[currentTextIndex][i]);
-                aproposShadow.setPosition(px + 2, py + 2);
-                aproposText.setPosition(px, py);
-                if (py > -50 && py < window.getSize().y - 80) { // Only draw if visible.
-                    window.draw(aproposShadow);
-                    window.draw(aproposText);
-                }
-            }
-            // If text scrolled past threshold, show next page.
-            if (scrollY + aproposTexts[currentTextIndex].size() * 40.f < -100.f) {
-                currentTextIndex = (currentTextIndex + 1) % aproposTexts.size();
-                aproposScrollClock.restart();
-            }
-            // Draw a fixed "RETOUR AU MENU" button.
-            sf::FloatRect rb = menu[3].getLocalBounds();
-            float rx = window.getSize().x / 2.f - (rb.width / 2.f + rb.left);
-            float ry = window.getSize().y - 60.f;
-            shadow[3].setPosition(rx + 2, ry + 2);
-            menu[3].setPosition(rx, ry);
-            menu[3].setFillColor(sf::Color(255, 255, 0, alpha));
-            shadow[3].setFillColor(sf::Color(0, 0, 0, alpha));
-            window.draw(shadow[3]);
-            window.draw(menu[3]);
-            window.display();
-            continue;
-        }
-        
-        // FINISH STATE:
-    // ===== FINISH STATE =====
-    // ===== FINISH STATE =====
-    else if (gameState == FINISH) {
-        // Real‑time finish‑screen loop with pulsating "RETOUR AU MENU"
-        sf::Clock finishClock;
-        // Main text + shadow
-        sf::Text returnBtn("RETOUR AU MENU", font, 28);
-        sf::Text returnBtnShadow = returnBtn;
-
-        // Center both texts once:
-        auto updateReturnBtnPos = [&]() {
-            auto bb = returnBtn.getLocalBounds();
-            sf::Vector2f pos(
-                window.getSize().x/2.f - (bb.width/2.f + bb.left),
-                window.getSize().y*0.6f + 250.f
-            );
-            returnBtn.setPosition(pos);
-            returnBtnShadow.setPosition(pos + sf::Vector2f(2.f, 2.f));
-        };
-        updateReturnBtnPos();
-
-        while (window.isOpen() && gameState == FINISH) {
-            float dt = finishClock.restart().asSeconds();
-            sf::Event ev;
-            while (window.pollEvent(ev)) {
-                if (ev.type == sf::Event::Closed) {
-                    window.close();
-                    break;
-                }
-                if (ev.type == sf::Event::KeyPressed && ev.key.code == sf::Keyboard::Enter) {
-                    clickSound.play();
-                    gameState = MENU; selected = 0; distanceTraveled = 0.f; score = 0; lives = 3;
-                }
-                if (ev.type == sf::Event::MouseButtonPressed &&
-                    returnBtn.getGlobalBounds().contains(
-                        static_cast<float>(ev.mouseButton.x),
-                        static_cast<float>(ev.mouseButton.y)
-                    ))
-                {
-                    clickSound.play();
-                    gameState = MENU; selected = 0; distanceTraveled = 0.f; score = 0; lives = 3;
-                }
-            }
-            if (!window.isOpen()) break;
-
-            // —— Pulsating alpha exactly like your menu buttons ——
-            float pulseTime = clock.getElapsedTime().asSeconds();
-            sf::Uint8 alpha = static_cast<sf::Uint8>(
-                127.5f * (std::sin(pulseTime * 2 * 3.14159265f) + 1)
-            );
-            // Yellow text + black shadow, both fading in/out
-            returnBtn.setFillColor(sf::Color(255, 255, 0, alpha));
-            returnBtnShadow.setFillColor(sf::Color(0,   0,   0, alpha));
-
-            // —— Draw everything every frame ——
-            window.clear();
-
-            // Title
-            sf::Text finishTitle("FELICITATIONS!", font, 64);
-            finishTitle.setFillColor(sf::Color::Yellow);
-            {
-                auto bb = finishTitle.getLocalBounds();
-                finishTitle.setPosition(
-                    window.getSize().x/2.f - (bb.width/2.f + bb.left),
-                    window.getSize().y*0.2f
-                );
-            }
-            window.draw(finishTitle);
-
-            // Score
-            sf::Text finishScore("Votre score est " + std::to_string(score), font, 32);
-            finishScore.setFillColor(sf::Color::White);
-            {
-                auto bb = finishScore.getLocalBounds();
-                finishScore.setPosition(
-                    window.getSize().x/2.f - (bb.width/2.f + bb.left),
-                    window.getSize().y*0.4f + 80.f
-                );
-            }
-            window.draw(finishScore);
-
-            // Return button with shadow
-            window.draw(returnBtnShadow);
-            window.draw(returnBtn);
-
-            window.display();
-        }
-
-        // If window was closed inside that loop, bail out of main loop too
-        if (!window.isOpen()) break;
-        continue;
-    }
-    // ===== GAME / HIT STATE =====
-
-
-    // ===== GAME / HIT STATE =====
-    else {
-        // Process input for boosting/braking
-        static bool triedWhileExhausted = false;
-    
-        bool boosting = false;
-        bool braking  = false;
-    
-        // Check if boost key is down
-        bool boostKeyDown =
-               sf::Keyboard::isKeyPressed(sf::Keyboard::W) ||
-               sf::Keyboard::isKeyPressed(sf::Keyboard::Up) ||
-               sf::Keyboard::isKeyPressed(sf::Keyboard::Space);
-    
-        if (boostKeyDown) {
-            if (stamina >= MIN_STAMINA_TO_BOOST) {
-                // Allowed to boost
-                boosting = true;
-                stamina  = std::max(0.f, stamina - STAMINA_DRAIN * dt);
-                triedWhileExhausted = false;   // reset flag once we successfully boost
-            } else {
-                // Not enough stamina—play tired sound one time
-                if (!triedWhileExhausted) {
-                    tiredSound.play();
-                    triedWhileExhausted = true;
-                }
-            }
-        } else {
-            // Once the player releases the boost key, allow the sound to trigger again next time
-            triedWhileExhausted = false;
-        }
-    
-        // Brake logic unchanged
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::S) ||
-            sf::Keyboard::isKeyPressed(sf::Keyboard::Down))
-        {
-            braking = true;
-        }
-    
-        // Regenerate stamina when not boosting
-        if (!boosting) {
-            stamina = std::min(MAX_STAMINA, stamina + STAMINA_REGEN * dt);
-        }
-    
-        if (!raceFinished) distanceTraveled += playerWorldSpeed;
-        stamina = std::min(MAX_STAMINA, stamina + STAMINA_REGEN * dt);
-
-        // Update world speed
-        if (boosting)        playerWorldSpeed = std::min(playerWorldSpeed + ACCEL, MAX_SPEED);
-        else if (braking)    playerWorldSpeed = 0.f;
-        else {
-            if (playerWorldSpeed < DEFAULT_SPEED)
-                playerWorldSpeed = std::min(playerWorldSpeed + ACCEL, DEFAULT_SPEED);
-            else if (playerWorldSpeed > DEFAULT_SPEED)
-                playerWorldSpeed = std::max(playerWorldSpeed - BRAKE_FORCE, DEFAULT_SPEED);
-        }
-
-        // Determine obstacle speed
-        float actualObstacleSpeed = braking ? -obstacleSpeed : obstacleSpeed;
-
-        // Draw grass margins
-        float rw = static_cast<float>(roadTexture.getSize().x);
-        float roadLeft = (window.getSize().x - rw) / 2.f;
-        grassOffset -= playerWorldSpeed;
-        if (grassOffset < 0.f)
-            grassOffset += static_cast<float>(grassTexture.getSize().y);
-        int winH = static_cast<int>(window.getSize().y);
-        int iRoadLeft = static_cast<int>(roadLeft);
-        sf::RectangleShape gL({ roadLeft, static_cast<float>(winH) });
-        sf::RectangleShape gR({ roadLeft, static_cast<float>(winH) });
-        gL.setPosition(0, 0);
-        gR.setPosition(roadLeft + rw, 0);
-        gL.setTexture(&grassTexture);
-        gR.setTexture(&grassTexture);
-        gL.setTextureRect({ 0, static_cast<int>(grassOffset), iRoadLeft, winH });
-        gR.setTextureRect({ 0, static_cast<int>(grassOffset), iRoadLeft, winH });
-        window.draw(gL);
-        window.draw(gR);
-
-        // Update and draw road tiles
-       // — Draw & wrap road tiles —
-for (auto &tile : roadTiles) {
-    // scroll
-    tile.move(0, playerWorldSpeed);
-
-    // if it moves off bottom, jump it back up by the total stacked height
-    if (tile.getPosition().y >= window.getSize().y) {
-        tile.setPosition(
-            tile.getPosition().x,
-            tile.getPosition().y - roadTileCount * tileH
-        );
-    }
-
-    // re‑center X
-    float roadLeft = (window.getSize().x - static_cast<float>(roadTexture.getSize().x)) / 2.f;
-    tile.setPosition(roadLeft, tile.getPosition().y);
-
-    // draw
-    window.draw(tile);
-}
-
-        
-        
-
-        // Spawn & move finish line
-        // — Spawn & move finish line —
-if (!finishLineSpawned && distanceTraveled >= FINISH_SPAWN_AT) {
-    finishLine.setTexture(finishLineTexture);
-    float scale = rw / static_cast<float>(finishLineTexture.getSize().x);
-    finishLine.setScale(scale, scale);
-    finishLine.setPosition(roadLeft, -finishLine.getGlobalBounds().height);
-    finishLineSpawned = true;
-}
-
-if (finishLineSpawned) {
-    finishLine.move(0, playerWorldSpeed);
-    window.draw(finishLine);
-
-    // Trigger on first contact
-    if (!finishTriggered && player.getGlobalBounds().intersects(finishLine.getGlobalBounds())) {
-        finishTriggered = true;
-        finishTriggerClock.restart();
-        finishSound.play();
-    }
-
-    // After 2s, switch to FINISH state
-if (finishTriggered && finishTriggerClock.getElapsedTime().asSeconds() >= FINISH_DELAY) {
-    gameState    = FINISH;
-    raceFinished = true;
-}
-
-}
-
-
-        // Spawn & update trees
-        if (std::rand() % 100 < 2 && (trees.empty() || trees.back().getPosition().y > 200)) {
-            sf::Sprite tr(treeTextures[std::rand() % 5]);
-            float tw = tr.getGlobalBounds().width, th = tr.getGlobalBounds().height;
-            bool leftSide = (std::rand() % 2) == 0;
-            float tx = leftSide
-                     ? (roadLeft > tw ? std::rand() % static_cast<int>(roadLeft - tw + 1) : 0)
-                     : (window.getSize().x - (roadLeft + rw) > tw
-                        ? roadLeft + rw + std::rand() % static_cast<int>(window.getSize().x - roadLeft - rw - tw + 1)
-                        : window.getSize().x - tw);
-            tr.setPosition(tx, -th);
-            trees.push_back(tr);
-        }
-        for (auto it = trees.begin(); it != trees.end(); ) {
-            it->move(0, playerWorldSpeed);
-            if (it->getPosition().y > window.getSize().y) it = trees.erase(it);
-            else { window.draw(*it); ++it; }
-        }
-
-        // Spawn & update obstacles
-        if (std::rand() % 100 < 10 && (obstacles.empty() || obstacles.back().getPosition().y > 150.f)) {
-            int lane = std::rand() % LANES;
-            sf::Sprite obs(eplayerTextures[std::rand() % 5]);
-            obs.setScale(0.20f, 0.20f);
-            float laneW = (rw - (padLeft + padRight) * rw) / LANES;
-            float cx_lane = roadLeft + padLeft * rw + laneW * (lane + 0.5f);
-            obs.setPosition(
-                cx_lane - obs.getGlobalBounds().width / 2.f,
-                -obs.getGlobalBounds().height - (std::rand() % 101 + 50)
-            );
-            obstacles.push_back(obs);
-        }
-        for (auto it = obstacles.begin(); it != obstacles.end(); ) {
-            it->move(0, (braking ? -obstacleSpeed : obstacleSpeed));
-            sf::FloatRect pb = player.getGlobalBounds();
-            pb.left += pb.width * 0.25f; pb.width *= 0.5f;
-            sf::FloatRect ob = it->getGlobalBounds();
-            ob.left += ob.width * 0.25f; ob.width *= 0.5f;
-            if (pb.intersects(ob) && gameState == GAME) {
-                crashSound.play(); lives--;
-                if (lives <= 0) gameState = MENU; else { gameState = HIT; fadeClock.restart(); }
-                it = obstacles.erase(it);
-            } else if (it->getPosition().y > window.getSize().y) {
-                it = obstacles.erase(it);
-                score += 10;
-            } else {
-                sf::Sprite sh = *it;
-                sh.move(5.f, 5.f);
-                sh.setColor(sf::Color(0, 0, 0, 150));
-                window.draw(sh);
-                window.draw(*it);
-                ++it;
-            }
-        }
-
-        // Smooth lane movement
-        {
-            float laneW = (rw - (padLeft + padRight) * rw) / LANES;
-            float pw = player.getGlobalBounds().width;
-            float playerTargetX = roadLeft + padLeft * rw + laneW * (playerLane + 0.5f) - pw / 2.f;
-            float bx = player.getPosition().x;
-            if (bx + 5.f < playerTargetX) player.move(5.f, 0.f);
-            else if (bx - 5.f > playerTargetX) player.move(-5.f, 0.f);
-            else player.setPosition(playerTargetX, player.getPosition().y);
-        }
-
-        // Hit blink effect
-        if (gameState == HIT) {
-            float ht = fadeClock.getElapsedTime().asSeconds();
-            if (ht < 2.f) {
-                uint8_t a = static_cast<uint8_t>(255 * std::abs(std::sin(ht * 10.f)));
-                player.setColor(sf::Color(255, 255, 255, a));
-            } else {
-                gameState = GAME;
-                player.setColor(sf::Color::White);
-            }
-        }
-
-        // Draw player and shadow
-        playerShadow.setPosition(player.getPosition().x + 5.f, player.getPosition().y + 5.f);
-        window.draw(playerShadow);
-        window.draw(player);
-
-        // Spawn and update collectibles
-        spawnBottle(bottles, bottleTex, rw, padLeft, padRight, LANES, window, obstacles, coins);
-        updateBottles(bottles, playerWorldSpeed, window, player, stamina, MAX_STAMINA, BOTTLE_STAMINA, drinkSound);
-        spawnScoreCoin(coins, coinTex, rw, padLeft, padRight, LANES, window, obstacles, bottles);
-        updateCoins(coins, playerWorldSpeed, window, player, score, coinSound);
-
-        // HUD: Score and Lives
-        sf::Text hud;
-        hud.setFont(font);
-        hud.setCharacterSize(24);
-        hud.setFillColor(sf::Color::White);
-        hud.setString("Score: " + std::to_string(score) + "  Lives: " + std::to_string(lives));
-        hud.setPosition(20.f, 20.f);
-        window.draw(hud);
-
-       
-
-            // Draw stamina bar
-    const float BAR_W = 20.f, BAR_H = 150.f;
-    float barX = window.getSize().x - BAR_W - 20.f;
-    float barY = (window.getSize().y - BAR_H) / 2.f;
-
-    // ← STAMINA label
-    staminaLabel.setPosition(
-        barX - staminaLabel.getGlobalBounds().width - 10.f,  // to the left of the bar
-        barY - staminaLabel.getCharacterSize()               // just above it
-    );
-    window.draw(staminaLabel);
-
-    sf::RectangleShape barBg(sf::Vector2f(BAR_W, BAR_H));
-    barBg.setPosition(barX, barY);
-    barBg.setFillColor(sf::Color(50, 50, 50, 200));
-    window.draw(barBg);
-
-    float fillH = (stamina / MAX_STAMINA) * BAR_H;
-    sf::RectangleShape barFill(sf::Vector2f(BAR_W, fillH));
-    barFill.setPosition(barX, barY + (BAR_H - fillH));
-    barFill.setFillColor(sf::Color(100, 100, 255, 200));
-    window.draw(barFill);
-
-
-    // Draw race progress bar
-    const float PB_W = 300.f, PB_H = 15.f;
-    float progress = std::min(1.f, distanceTraveled / RACE_DISTANCE);
-    float pbX = (window.getSize().x - PB_W) / 2.f;
-    float pbY = window.getSize().y - PB_H - 10.f;
-
-    // ← VOTRE POSITION label
-    positionLabel.setPosition(
-        pbX,                                                  // align left edge to bar
-        pbY - positionLabel.getCharacterSize() - 5.f          // just above bar
-    );
-    window.draw(positionLabel);
-
-    sf::RectangleShape progressBg(sf::Vector2f(PB_W, PB_H));
-    progressBg.setPosition(pbX, pbY);
-    progressBg.setFillColor(sf::Color(50, 50, 50, 200));
-    window.draw(progressBg);
-
-    sf::RectangleShape progressFill(sf::Vector2f(PB_W * progress, PB_H));
-    progressFill.setPosition(pbX, pbY);
-    progressFill.setFillColor(sf::Color(100, 255, 100, 220));
-    window.draw(progressFill);
-
-    window.display();
-
-    } // End GAME/HIT state
-
-    // Loop back to start of main while
-} // End while(window.isOpen())
-
-return 0;
-} // End main
\ No newline at end of file
+#include <SFML/Graphics.hpp>
+#include <SFML/Audio.hpp>
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <chrono>
+#include <thread>
+
+#include "AssetLoader.hpp"
+#include "Autopilot.hpp"
+#include "BatchRunner.hpp"
+#include "BenchScenarios.hpp"
+#include "FramePacer.hpp"
+#include "JobSystem.hpp"
+#include "Profiler.hpp"
+#include "ResourceArchive.hpp"
+#include "RaceHistory.hpp"
+#include "RaceRecording.hpp"
+#include "RaceSimulation.hpp"
+#include "ScreenCache.hpp"
+#include "SimThread.hpp"
+#include "SpriteBatch.hpp"
+#include "Telemetry.hpp"
+#include "TextureAtlas.hpp"
+#include "UiText.hpp"
+#include "VoicePool.hpp"
+
+//
+// Count every heap allocation for the profiler's allocation counter.
+//
+void *operator new(std::size_t size)
+{
+    ++allocationCount();
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+//
+// Command line options.
+//
+struct LaunchOptions {
+    bool headless = false;       // --headless [steps]: no window at all
+    int steps = 100000;
+    std::string replayPath;      // --replay file: play a recorded race back
+    std::string recordPath;      // --record file: record every race started from the menu
+    bool hasSeed = false;        // --seed n: seed of the first race
+    std::uint64_t seed = 0;
+    bool profile = false;        // --profile: start with the profiler overlay shown (F3 toggles it)
+    std::string tracePath;       // --trace file: write a Chrome trace of the session on exit
+    std::string benchName;       // --bench scenario [frames]: scripted stress run, then exit
+    int benchFrames = 3000;
+    unsigned fps = 60;           // --fps n: frame rate of the race, 0 = uncapped (60/120/144...)
+    bool vsync = false;          // --vsync: sync to the display, whose refresh rate is --fps
+    std::string sweepPath;       // --sweep out.csv: windowless balance sweep, aggregated to CSV
+    std::vector<std::string> sweepAxes;  // --param name=v1,v2,...: one grid axis (repeatable)
+    std::uint64_t sweepFirstSeed = 1;    // --seeds first:count: seeds raced per combination
+    int sweepSeeds = 100;
+    float sweepMaxSeconds = 600.f;       // --max-seconds n: cut a sweep race off after n s of race time
+    bool autopilot = false;      // --autopilot: the autopilot drives every race (soak tests; --headless too)
+    bool dev = false;            // --dev: developer keys (F5 rewinds the race by 2 s)
+    std::string telemetryPath;   // --telemetry file: log gameplay and frame events to file.0, file.1, ...
+};
+
+LaunchOptions parseOptions(int argc, char **argv)
+{
+    LaunchOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc && argv[i + 1][0] != '-';
+        if (arg == "--headless") {
+            opts.headless = true;
+            if (hasValue) {
+                int steps = std::atoi(argv[++i]);
+                if (steps > 0) opts.steps = steps;
+            }
+        } else if (arg == "--replay" && hasValue) {
+            opts.replayPath = argv[++i];
+        } else if (arg == "--record" && hasValue) {
+            opts.recordPath = argv[++i];
+        } else if (arg == "--bench" && hasValue) {
+            opts.benchName = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                int frames = std::atoi(argv[++i]);
+                if (frames > 0) opts.benchFrames = frames;
+            }
+        } else if (arg == "--fps" && hasValue) {
+            opts.fps = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--vsync") {
+            opts.vsync = true;
+        } else if (arg == "--sweep" && hasValue) {
+            opts.sweepPath = argv[++i];
+        } else if (arg == "--param" && hasValue) {
+            opts.sweepAxes.push_back(argv[++i]);
+        } else if (arg == "--seeds" && hasValue) {
+            std::string range = argv[++i];
+            std::size_t colon = range.find(':');
+            opts.sweepFirstSeed = std::strtoull(range.c_str(), nullptr, 10);
+            if (colon != std::string::npos)
+                opts.sweepSeeds = std::max(1, std::atoi(range.c_str() + colon + 1));
+        } else if (arg == "--max-seconds" && hasValue) {
+            float secs = static_cast<float>(std::atof(argv[++i]));
+            if (secs > 0.f) opts.sweepMaxSeconds = secs;
+        } else if (arg == "--autopilot") {
+            opts.autopilot = true;
+        } else if (arg == "--dev") {
+            opts.dev = true;
+        } else if (arg == "--telemetry" && hasValue) {
+            opts.telemetryPath = argv[++i];
+        } else if (arg == "--profile") {
+            opts.profile = true;
+        } else if (arg == "--trace" && hasValue) {
+            opts.tracePath = argv[++i];
+        } else if (arg == "--seed" && hasValue) {
+            opts.hasSeed = true;
+            opts.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Ignoring unknown option " << arg << "\n";
+        }
+    }
+    return opts;
+}
+
+//
+// Helper: Unscaled size of a texture or image, as the simulation wants it.
+//
+SpriteSize sizeOf(const sf::Vector2u &s)
+{
+    return { static_cast<float>(s.x), static_cast<float>(s.y) };
+}
+
+//
+// Helper: Reads the texture sizes the race needs from resources.pak or the image files,
+// without creating a window or any texture.
+//
+bool loadRaceGeometry(RaceConfig &cfg)
+{
+    ResourceArchive archive;
+    archive.open("resources.pak");
+    auto imageSize = [&](const std::string &path, SpriteSize &out) {
+        ResourceArchive::Resource res = archive.find(path);
+        if (res && res.entry->kind == ArchiveEntry::IMAGE) {
+            out.w = static_cast<float>(res.width());
+            out.h = static_cast<float>(res.height());
+            return true;
+        }
+        sf::Image img;
+        if (!img.loadFromFile(path)) {
+            std::cerr << "Failed to load " << path << "\n";
+            return false;
+        }
+        out = sizeOf(img.getSize());
+        return true;
+    };
+    if (!imageSize("resources/images/road.png", cfg.road) ||
+        !imageSize("resources/images/grass.png", cfg.grass) ||
+        !imageSize("resources/images/finish.png", cfg.finishLine) ||
+        !imageSize("resources/images/player.png", cfg.player) ||
+        !imageSize("resources/images/coins/bottle.png", cfg.bottle) ||
+        !imageSize("resources/images/coins/score.png", cfg.coin))
+        return false;
+    for (int i = 1; i < RaceConfig::TREE_KINDS; ++i)
+        if (!imageSize("resources/images/trees/tree" + std::to_string(i) + ".png", cfg.trees[i]))
+            return false;
+    for (int i = 0; i < RaceConfig::OBSTACLE_KINDS; ++i)
+        if (!imageSize("resources/images/obstacles/eplayer" + std::to_string(i+1) + ".png", cfg.obstacles[i]))
+            return false;
+    return true;
+}
+
+//
+// Helper: Builds the player and obstacle collision masks at the config's
+// draw scales from resources.pak or the image files (for headless runs; the
+// game builds them from the images it loads anyway).
+//
+bool loadCollisionMasks(const RaceConfig &cfg, CollisionMasks &masks)
+{
+    ResourceArchive archive;
+    archive.open("resources.pak");
+    auto build = [&](const std::string &path, float scale, CollisionMask &out) {
+        ResourceArchive::Resource res = archive.find(path);
+        if (res && res.entry->kind == ArchiveEntry::IMAGE) {
+            out = CollisionMask::fromRgba(res.pixels(), res.width(), res.height(), scale);
+            return true;
+        }
+        sf::Image img;
+        if (!img.loadFromFile(path)) {
+            std::cerr << "Failed to load " << path << "\n";
+            return false;
+        }
+        out = CollisionMask::fromRgba(img.getPixelsPtr(), img.getSize().x, img.getSize().y, scale);
+        return true;
+    };
+    if (!build("resources/images/player.png", cfg.playerScale, masks.player))
+        return false;
+    for (int i = 0; i < RaceConfig::OBSTACLE_KINDS; ++i)
+        if (!build("resources/images/obstacles/eplayer" + std::to_string(i+1) + ".png", cfg.obstacleScale, masks.obstacles[i]))
+            return false;
+    return true;
+}
+
+//
+// Helper: Prints where a race ended up, in a form that is easy to diff.
+//
+void printRaceResult(const RaceSimulation &sim, long steps, float secs)
+{
+    std::cout << "seed=" << sim.seed << " steps=" << steps
+              << " state=" << sim.state << " score=" << sim.score << " lives=" << sim.lives
+              << " distance=" << sim.distanceTraveled
+              << " steps_per_sec=" << (secs > 0.f ? steps / secs : 0.f) << "\n";
+}
+
+//
+// Helper: Runs races without a window and prints the result. With --replay
+// the recorded race is played back; otherwise races with no input are run
+// back to back for --headless steps, with no input or driven by --autopilot.
+//
+int runHeadless(const LaunchOptions &opts)
+{
+    if (!opts.replayPath.empty()) {
+        RaceRecording rec;
+        if (!rec.load(opts.replayPath)) {
+            std::cerr << "Failed to load replay " << opts.replayPath << "\n";
+            return -1;
+        }
+        // Crashes depend on the collision masks, so the replay needs them too.
+        CollisionMasks masks;
+        if (!loadCollisionMasks(rec.config, masks))
+            std::cerr << "Replaying without collision masks; crashes may differ from the recording\n";
+        RaceSimulation sim;
+        sim.masks = &masks;
+        RaceReplay replay(rec);
+        replay.start(sim);
+        RaceInput in;
+        long steps = 0;
+        sf::Clock timer;
+        while ((sim.state == GAME || sim.state == HIT) && replay.next(sim, in)) {
+            sim.step(in, RaceSimulation::STEP_DT);
+            ++steps;
+        }
+        printRaceResult(sim, steps, timer.getElapsedTime().asSeconds());
+        return 0;
+    }
+
+    RaceConfig cfg;
+    CollisionMasks masks;
+    if (!loadRaceGeometry(cfg) || !loadCollisionMasks(cfg, masks))
+        return -1;
+
+    RaceSimulation sim(cfg);
+    sim.masks = &masks;
+    std::uint64_t seed = opts.hasSeed ? opts.seed : static_cast<std::uint64_t>(std::time(nullptr));
+    sim.reset(seed);
+    RaceInput idle;
+    Autopilot autopilot;
+    int races = 1;
+    sf::Clock timer;
+    for (int i = 0; i < opts.steps; ++i) {
+        sim.step(opts.autopilot ? autopilot.drive(sim) : idle, RaceSimulation::STEP_DT);
+        if (sim.state != GAME && sim.state != HIT) {
+            sim.reset(++seed);
+            autopilot.reset();
+            ++races;
+        }
+    }
+    std::cout << "races=" << races << " ";
+    printRaceResult(sim, opts.steps, timer.getElapsedTime().asSeconds());
+    return 0;
+}
+
+//
+// Helper: Runs a --sweep: every combination of the --param values raced
+// with every --seeds seed on all cores, aggregated into a CSV file.
+//
+int runSweep(const LaunchOptions &opts)
+{
+    std::vector<SweepAxis> axes;
+    for (const std::string &spec : opts.sweepAxes) {
+        std::size_t eq = spec.find('=');
+        SweepAxis axis;
+        axis.param = findSweepParam(spec.substr(0, eq));
+        if (!axis.param || eq == std::string::npos) {
+            std::cerr << "Bad --param " << spec << "; expected name=v1,v2,... with name one of:";
+            for (const SweepParam &p : sweepParams())
+                std::cerr << " " << p.name;
+            std::cerr << "\n";
+            return 1;
+        }
+        for (std::size_t pos = eq + 1; pos <= spec.size(); ) {
+            std::size_t comma = std::min(spec.find(',', pos), spec.size());
+            if (comma > pos)
+                axis.values.push_back(static_cast<float>(std::atof(spec.substr(pos, comma - pos).c_str())));
+            pos = comma + 1;
+        }
+        if (axis.values.empty()) {
+            std::cerr << "--param " << spec << " has no values\n";
+            return 1;
+        }
+        axes.push_back(axis);
+    }
+
+    RaceConfig cfg;
+    CollisionMasks masks;
+    if (!loadRaceGeometry(cfg) || !loadCollisionMasks(cfg, masks))
+        return -1;
+
+    // All cores: the calling thread works through the races too.
+    JobSystem jobs(std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+    BatchRunner runner(cfg, &masks);
+    sf::Clock timer;
+    std::vector<SweepResult> results = runner.run(axes, opts.sweepFirstSeed, opts.sweepSeeds, opts.sweepMaxSeconds, jobs);
+    float secs = timer.getElapsedTime().asSeconds();
+    if (!BatchRunner::writeCsv(opts.sweepPath, axes, results)) {
+        std::cerr << "Failed to write " << opts.sweepPath << "\n";
+        return -1;
+    }
+    std::cout << "sweep combinations=" << results.size() << " races=" << results.size() * opts.sweepSeeds
+              << " threads=" << jobs.workerCount() + 1 << " secs=" << secs << " -> " << opts.sweepPath << "\n";
+    return 0;
+}
+
+//
+// Helper: Text of the profiler overlay.
+//
+std::string profilerReport(const Profiler &prof, const FramePacer &pacer)
+{
+    char line[96];
+    std::string out;
+    std::snprintf(line, sizeof line, "frame p50 %.2f  p99 %.2f  max %.2f ms\n",
+                  prof.percentile(ZONE_FRAME, 0.5f), prof.percentile(ZONE_FRAME, 0.99f),
+                  prof.percentile(ZONE_FRAME, 1.f));
+    out += line;
+    const FrameHistogram &pacing = pacer.histogram();
+    std::snprintf(line, sizeof line, "pacing @%u  p50 %+.2f  p99 %+.2f ms  late>1ms %.1f%%\n",
+                  pacer.target(), pacing.percentile(0.5f), pacing.percentile(0.99f),
+                  100.f * pacing.lateFraction(1.f));
+    out += line;
+    for (int z = ZONE_EVENTS; z < ZONE_COUNT; ++z) {
+        ProfileZone zone = static_cast<ProfileZone>(z);
+        std::snprintf(line, sizeof line, "%-14s %6.3f  p99 %6.3f\n", Profiler::zoneName(z),
+                      prof.percentile(zone, 0.5f), prof.percentile(zone, 0.99f));
+        out += line;
+    }
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        std::snprintf(line, sizeof line, "%s: %lld\n", Profiler::counterName(c),
+                      static_cast<long long>(prof.counter(static_cast<ProfileCounter>(c))));
+        out += line;
+    }
+    return out;
+}
+
+//
+// Main function with game loop and helper functions.
+//
+int main(int argc, char **argv) {
+    LaunchOptions opts = parseOptions(argc, argv);
+    if (!opts.sweepPath.empty())
+        return runSweep(opts);
+    if (opts.headless)
+        return runHeadless(opts);
+
+    const BenchScenario *benchScenario = nullptr;
+    if (!opts.benchName.empty()) {
+        benchScenario = findBenchScenario(opts.benchName);
+        if (!benchScenario) {
+            std::cerr << "Unknown bench scenario " << opts.benchName << ", try one of:\n";
+            for (const BenchScenario &s : benchScenarios())
+                std::cerr << "  " << s.name << " - " << s.description << "\n";
+            return 1;
+        }
+    }
+
+    sf::RenderWindow window(sf::VideoMode(800, 600), "Bike Game", sf::Style::Default);
+    // SFML's limiter is off (its plain sleep overshoots): FramePacer paces
+    // the frames, and benchmarks skip it to run unthrottled.
+    window.setFramerateLimit(0);
+    bool vsync = opts.vsync && !benchScenario;
+    window.setVerticalSyncEnabled(vsync);
+    FramePacer pacer;
+    pacer.setVsync(vsync ? opts.fps : 0);
+    
+    GameState gameState = MENU;
+
+    // — ASSETS —
+    // resources.pak (tools/pack_resources) is used when present, the loose
+    // files under resources/ otherwise.
+    ResourceArchive archive;
+    archive.open("resources.pak");
+
+    sf::Font font;
+    ResourceArchive::Resource fontRes = archive.find("resources/fonts/Pixelite.ttf");
+    if (fontRes ? !font.loadFromMemory(fontRes.data, fontRes.size())
+                : !font.loadFromFile("resources/fonts/Pixelite.ttf")) {
+        std::cerr << "Failed to load font\n";
+        return -1;
+    }
+    
+    // Everything else is decoded on worker threads while the menu is up and
+    // finished a slice per frame (see AssetLoader); the menu background and
+    // the click go first.
+    AssetLoader loader(&archive);
+
+    // Static screens (menu, about, finish) are composed once into this cache
+    // and only their pulsing parts are drawn every frame.
+    ScreenCache screenCache;
+
+    sf::Texture bgTexture;
+    sf::Sprite bgSprite;
+    loader.texture("resources/images/bgmenu.jpg", bgTexture, true,
+                   [&] { bgSprite.setTexture(bgTexture, true); screenCache.invalidate(); });
+
+    sf::Music bgMusic;
+    ResourceArchive::Resource musicRes = archive.find("resources/audios/bgmenu.ogg");
+    if (musicRes ? bgMusic.openFromMemory(musicRes.data, musicRes.size())
+                 : bgMusic.openFromFile("resources/audios/bgmenu.ogg")) {
+        bgMusic.setLoop(true);
+        bgMusic.setVolume(25.f);
+        bgMusic.play();
+    }
+    
+    sf::SoundBuffer clickBuf, crashBuf, drinkBuf, coinBuf, finishBuf, tiredBuf;
+    loader.sound("resources/audios/click.wav", clickBuf);
+    loader.sound("resources/audios/crash.wav", crashBuf);
+    loader.sound("resources/audios/drink.wav", drinkBuf);
+    loader.sound("resources/audios/coin.wav", coinBuf);
+    loader.sound("resources/audios/tired.wav", tiredBuf);
+    loader.sound("resources/audios/finish.wav", finishBuf);
+
+    // Every effect plays on a voice from this pool, so they can overlap.
+    VoicePool voices;
+    
+    sf::Texture finishLineTexture, roadTexture;
+    loader.texture("resources/images/finish.png", finishLineTexture, false);
+    roadTexture.setRepeated(true);
+    loader.texture("resources/images/road.png", roadTexture);
+
+
+    // — UI TEXT —
+    // Every string on screen is a retained UiText drawn from one prebaked
+    // glyph atlas, so all text of a frame is a single batched draw.
+    SpriteBatch batch;  // every race sprite, HUD bar and UI text goes through here
+    GlyphAtlas glyphs;
+    if (!glyphs.build(font, { 16, 24, 28, 30, 32, 64 })) {
+        std::cerr << "Failed to build the glyph atlas\n";
+        return -1;
+    }
+
+    // — MENU TEXTS —
+    std::string labels[4] = {"Jouer", "A propos", "Quitter", "RETOUR"};
+    UiText menu[4];
+    for (int i = 0; i < 4; ++i)
+        menu[i] = UiText(glyphs, 32, labels[i]);
+    int selected = 0;
+
+    // Put each letter on its own line:
+    UiText staminaLabel(glyphs, 24, "S\nT\nA\nM\nI\nN\nA");
+    UiText positionLabel(glyphs, 24, "VOTRE POSITION :");
+    UiText hud(glyphs, 24);
+    int hudScore = -1, hudLives = -1;  // what hud currently shows
+
+    UiText loadingText(glyphs, 30);
+    int loadingPercent = -1;
+
+    UiText demoText(glyphs, 32, "DEMO - appuyez sur une touche");
+    UiText replayText(glyphs, 32, "REPLAY");
+
+    UiText finishTitle(glyphs, 64, "FELICITATIONS!");
+    UiText finishScore(glyphs, 32);
+    UiText returnBtn(glyphs, 28, "RETOUR AU MENU");
+
+    
+    // — “A PROPOS” SCROLLING TEXT —
+    std::vector<std::vector<std::string>> aproposTexts = {{
+        "Bienvenue dans notre projet de mini-jeu de velo",
+        "Realise par Mahmoud Moukouch & Mohamed Lakhdar",
+        "Encadre par Professeur Rachida Hannane",
+        "Dans notre filiere IAPS4 a l'Universite FSSM Marrakech",
+        "Ce jeu est conçu pour offrir une experience immersive",
+        "Avec des graphismes futuristes et un gameplay dynamique",
+        "Le but est de collecter des objets tout en evitant des obstacles",
+        "- Collecte de bouteilles pour gagner des points",
+        "- Evitez les autres velos sur la route",
+        "- Profitez de l'adrenaline d'une course a grande vitesse",
+        "- Compteur de score pour suivre vos progres",
+        "- Limite de temps pour rendre le defi encore plus excitant",
+        "Nous esperons que vous apprecierez ce jeu innovant!",
+        "Merci de jouer et bonne chance!"
+    }};
+    std::vector<std::vector<UiText>> aproposLines(aproposTexts.size());
+    for (size_t p = 0; p < aproposTexts.size(); ++p)
+        for (const std::string &line : aproposTexts[p])
+            aproposLines[p].push_back(UiText(glyphs, 28, line));
+    size_t currentTextIndex = 0;
+    
+    // — CLOCKS —
+    sf::Clock clock;               // For pulsing alpha
+    sf::Clock aproposScrollClock;  // For "A Propos" scrolling
+    
+    // — GAME ASSETS & STATE —
+    sf::Texture grassTexture;
+    // Trees, obstacles, collectibles and the player share one atlas so the
+    // whole entity layer is drawn with a single texture bind.
+    sf::Image playerImage, bottleImage, coinImage;
+    std::vector<sf::Image> treeImages(RaceConfig::TREE_KINDS), eplayerImages(RaceConfig::OBSTACLE_KINDS);
+    TextureAtlas entityAtlas;
+    int playerRegion = -1, bottleRegion = -1, coinRegion = -1;
+    int treeRegions[RaceConfig::TREE_KINDS], eplayerRegions[RaceConfig::OBSTACLE_KINDS];
+    bool assetsLoaded = false;
+    
+    // Session telemetry (--telemetry), fed by this thread and the simulation's.
+    std::unique_ptr<Telemetry> telemetry;
+    if (!opts.telemetryPath.empty()) {
+        telemetry.reset(new Telemetry);
+        if (!telemetry->open(opts.telemetryPath)) {
+            std::cerr << "Failed to open telemetry log " << opts.telemetryPath << ".0\n";
+            telemetry.reset();
+        }
+    }
+
+    // The race itself: lanes, entities, stamina, score and lives.
+    RaceConfig raceConfig;
+    // It is stepped on its own thread while a race is on; the main thread
+    // only touches it directly between races.
+    RaceSimulation sim;
+    SimThread simThread(sim);
+    CollisionMasks collisionMasks;  // pixel-exact crashes, built from the player and obstacle images
+    Autopilot autopilot;  // drives --autopilot races and the menu's attract mode, on the simulation thread
+    RaceHistory history;  // the last seconds of the race, recorded by the simulation thread
+    HistoryPlayback killCam;  // after a crash, the seconds before it again at half speed
+    sf::Clock killCamClock;
+    RaceInput pendingInput;  // lane changes collected from key presses
+    sf::Vector2u replaySize;  // window size last set by the replay
+
+    // Every race gets its own seed; --seed fixes the first one.
+    std::uint64_t nextSeed = opts.hasSeed ? opts.seed : static_cast<std::uint64_t>(std::time(nullptr));
+    bool recordRaces = !opts.recordPath.empty();
+    RaceRecording recording;    // race being recorded (--record)
+    RaceRecording replayData;   // race being played back (--replay)
+    RaceReplay replay(replayData);
+    bool replaying = false;
+
+    // Attract mode: after a while on the menu with no key pressed, the
+    // autopilot races a demo until a key is pressed or the race ends.
+    const float ATTRACT_AFTER = 20.f;
+    sf::Clock menuIdleClock;
+    bool attract = false;
+    std::uint64_t demoSeed = 1;
+    
+    // — ROAD GEOMETRY —
+    int roadTileCount = 0;  // how many road sprites to cover the window
+    float tileH = 0.f;  // will be set once roadTexture is loaded
+
+    auto rebuildRoad = [&](sf::RenderWindow &win, const sf::Texture &roadTexture,int &roadTileCount,float &tileH)
+    {
+    // compute strip height
+    tileH = static_cast<float>(roadTexture.getSize().y);
+    float winH = static_cast<float>(win.getSize().y);
+    roadTileCount = static_cast<int>(std::ceil(winH / tileH)) + 1;
+    };
+
+    // — Queue the race textures and start decoding —
+    grassTexture.setRepeated(true);
+    loader.texture("resources/images/grass.png", grassTexture);
+    loader.image("resources/images/player.png", playerImage);
+    // — ENVIRONMENT SPRITES (trees) —
+    for (int i = 1; i < RaceConfig::TREE_KINDS; ++i)
+        loader.image("resources/images/trees/tree" + std::to_string(i) + ".png", treeImages[i]);
+    // — OBSTACLES (eplayers) —
+    for (int i = 0; i < RaceConfig::OBSTACLE_KINDS; ++i)
+        loader.image("resources/images/obstacles/eplayer" + std::to_string(i+1) + ".png", eplayerImages[i]);
+    // — COLLECTIBLES (bottle and score coins) —
+    loader.image("resources/images/coins/bottle.png", bottleImage);
+    loader.image("resources/images/coins/score.png", coinImage);
+    loader.start();
+
+    // — Replay: load the recording now, the race starts once assets are in —
+    bool replayPending = false;
+    if (!opts.replayPath.empty())
+    {
+        if (!replayData.load(opts.replayPath))
+        {
+            std::cerr << "Failed to load replay " << opts.replayPath << "\n";
+            return -1;
+        }
+        replayPending = true;
+        gameState = LOADING;
+    }
+
+    // — Bench: straight into the scenario's race once assets are in —
+    std::vector<float> benchFrameMs;
+    double benchEntities = 0.0;  // live entities summed over the measured frames
+    int benchFrame = 0;
+    int benchRaceFrames = 0;  // lockstep frames sent to the current race
+    int benchOverflowed = 0;  // course items of finished bench races that didn't fit their chunk
+    sf::Clock benchClock;
+    if (benchScenario)
+    {
+        benchFrameMs.reserve(opts.benchFrames);
+        nextSeed = opts.hasSeed ? opts.seed : 1;
+        gameState = LOADING;
+    }
+    
+    // — PROFILER —
+    Profiler &profiler = Profiler::instance();
+    bool showProfiler = opts.profile;
+    profiler.enabled = showProfiler;
+    if (!opts.tracePath.empty())
+        profiler.startTrace();
+    UiText profilerText(glyphs, 16);
+    sf::Clock profilerTextClock;  // the overlay text is refreshed a few times a second
+    std::uint64_t allocationsSeen = allocationCount();
+
+    // Draws the menu background scaled to cover the window (once it has been loaded).
+    auto drawBackground = [&](sf::RenderTarget &target) {
+        if (!bgSprite.getTexture())
+            return;
+        sf::FloatRect bgBounds = bgSprite.getLocalBounds();
+        float scaleX = target.getSize().x / bgBounds.width;
+        float scaleY = target.getSize().y / bgBounds.height;
+        float scale = std::max(scaleX, scaleY);
+        bgSprite.setScale(scale, scale);
+        target.draw(bgSprite);
+    };
+
+    // Frame rate follows what is on screen: static screens only need their
+    // pulse, and an unfocused window (race paused) hardly needs updating.
+    bool focused = true;
+    bool focusPaused = false;  // the race was paused because the window lost focus
+    unsigned staticFps = opts.fps ? std::min(opts.fps, 30u) : 30u;
+    auto applyFrameLimit = [&] {
+        pacer.setTarget(benchScenario ? 0
+                        : !focused ? 5
+                        : (gameState == MENU || gameState == FINISH) ? staticFps : opts.fps);
+    };
+    applyFrameLimit();
+
+    // Telemetry: every frame's interval and every change of state, logged
+    // at the start of the next frame. The attract-mode demo is nobody's
+    // gameplay: to the log the game stays in the menu while it runs.
+    sf::Clock telemetryFrameClock;
+    GameState telemetryState = gameState;
+    auto logFrame = [&] {
+        if (!telemetry)
+            return;
+        telemetry->log(TELEMETRY_FRAME, static_cast<int>(pacer.target()),
+                       static_cast<std::int32_t>(telemetryFrameClock.restart().asMicroseconds()));
+        if (gameState != telemetryState && !attract) {
+            telemetry->log(TELEMETRY_STATE, gameState, telemetryState);
+            telemetryState = gameState;
+        }
+    };
+
+    // — GAME LOOP —
+    
+    while (window.isOpen())
+    {
+        {
+            PROFILE_SCOPE(ZONE_PACE);
+            pacer.wait();
+        }
+        logFrame();
+        std::uint64_t allocations = allocationCount();
+        profiler.setCounter(COUNTER_ALLOCATIONS, static_cast<std::int64_t>(allocations - allocationsSeen));
+        allocationsSeen = allocations;
+        profiler.endFrame();
+        profiler.beginFrame();
+
+        // — inside your main loop —  
+        ProfileScope eventsScope(ZONE_EVENTS);
+        sf::Event ev;
+        while (window.pollEvent(ev))
+        {
+            // 1) Handle window close
+            if (ev.type == sf::Event::Closed)
+            {    window.close();
+            // 2) Handle resize
+            }
+            // Pause the race while the window is in the background.
+            else if (ev.type == sf::Event::LostFocus) {
+                focused = false;
+                if (!benchScenario && simThread.running()) {
+                    simThread.pause();
+                    focusPaused = true;
+                }
+            }
+            else if (ev.type == sf::Event::GainedFocus) {
+                focused = true;
+                if (focusPaused) {
+                    simThread.resume();
+                    focusPaused = false;
+                }
+            }
+            else if (ev.type == sf::Event::Resized) {
+        // adjust view to new window size
+        sf::FloatRect visibleArea(0, 0, ev.size.width, ev.size.height);
+        window.setView(sf::View(visibleArea));
+
+        // reposition the player in its lane
+        // (a replay only follows the resizes it recorded)
+        if (simThread.running()) {
+            SimCommand resize;
+            resize.type = SimCommand::RESIZE;
+            resize.w = static_cast<float>(ev.size.width);
+            resize.h = static_cast<float>(ev.size.height);
+            simThread.send(resize);
+        } else if (!replaying) {
+            sim.resize(static_cast<float>(ev.size.width), static_cast<float>(ev.size.height));
+        }
+
+        // rebuild the vertical stack of road tiles
+        if (assetsLoaded)
+            rebuildRoad(window, roadTexture, roadTileCount, tileH);
+    }
+    // F3 shows / hides the profiler overlay
+    else if (ev.type == sf::Event::KeyPressed && ev.key.code == sf::Keyboard::F3) {
+        showProfiler = !showProfiler;
+        profiler.enabled = showProfiler || profiler.tracing();
+    }
+    // F5 (--dev) rewinds the race by 2 s. Not while recording or replaying:
+    // the recording would no longer match the race.
+    else if (ev.type == sf::Event::KeyPressed && ev.key.code == sf::Keyboard::F5 && opts.dev) {
+        if (simThread.running() && !attract && !benchScenario && !replaying && !recordRaces && !killCam.active()) {
+            simThread.pause();
+            history.rewind(sim, RaceHistory::stepsOf(2.f));
+            autopilot.reset();  // its plan was for the race before the rewind
+            pendingInput = RaceInput();
+            simThread.resume();
+        }
+    }
+    // 3) Keyboard input
+    else if (ev.type == sf::Event::KeyPressed) {
+        menuIdleClock.restart();
+        if (attract) {
+            // Any key ends the demo.
+            simThread.pause();
+            focusPaused = false;
+            attract = false;
+            gameState = MENU;
+        }
+        else if (killCam.active()) {
+            // Any key skips the kill-cam.
+            killCam.stop();
+            simThread.resume();
+        }
+        else if (gameState == MENU) {
+            if (ev.key.code == sf::Keyboard::Up)
+                selected = (selected + 2) % 3;
+            else if (ev.key.code == sf::Keyboard::Down)
+                selected = (selected + 1) % 3;
+            else if (ev.key.code == sf::Keyboard::Enter) {
+                voices.play(clickBuf, PRIORITY_NORMAL);
+                if (selected == 0) {
+                    gameState = LOADING;
+                }
+                else if (selected == 1) {
+                    gameState = APROPOS;
+                    aproposScrollClock.restart();
+                    currentTextIndex = 0;
+                }
+                else if (selected == 2) {
+                    window.close();
+                }
+            }
+        }
+        
+        else if (gameState == APROPOS) {
+            if (ev.key.code == sf::Keyboard::Enter) {
+                voices.play(clickBuf, PRIORITY_NORMAL);
+                gameState = MENU;
+                selected = 0;
+            }
+        }
+        else if (gameState == GAME || gameState == HIT) {
+            if (ev.key.code == sf::Keyboard::A || ev.key.code == sf::Keyboard::Left)
+                pendingInput.laneChange--;
+            else if (ev.key.code == sf::Keyboard::D || ev.key.code == sf::Keyboard::Right)
+                pendingInput.laneChange++;
+        }
+    }
+    // you can add other event types (mouse clicks, etc.) here as else if …
+} // End of event polling
+        eventsScope.stop();
+        if (gameState != MENU)
+            menuIdleClock.restart();
+        applyFrameLimit();
+
+        // — Finish loading assets a slice at a time —
+        // The loading screen has nothing else to do and gets a bigger share.
+        if (!assetsLoaded && loader.update(gameState == LOADING ? 0.012f : 0.004f))
+        {
+            if (loader.failed())
+                return -1;
+
+            // — Pack the entity sprites into the atlas —
+            playerRegion = entityAtlas.add(playerImage);
+            bottleRegion = entityAtlas.add(bottleImage);
+            coinRegion   = entityAtlas.add(coinImage);
+            for (int i = 0; i < RaceConfig::TREE_KINDS; ++i)
+                treeRegions[i] = entityAtlas.add(treeImages[i]);
+            for (int i = 0; i < RaceConfig::OBSTACLE_KINDS; ++i)
+                eplayerRegions[i] = entityAtlas.add(eplayerImages[i]);
+            if (!entityAtlas.build())
+            {
+                std::cerr << "Failed to build the entity texture atlas\n";
+                return -1;
+            }
+
+            // — Stack the road sprites so bottom is covered immediately —
+            rebuildRoad(window, roadTexture, roadTileCount, tileH);
+
+            // — Hand the texture geometry to the simulation —
+            raceConfig.viewWidth  = static_cast<float>(window.getSize().x);
+            raceConfig.viewHeight = static_cast<float>(window.getSize().y);
+            raceConfig.road       = sizeOf(roadTexture.getSize());
+            raceConfig.grass      = sizeOf(grassTexture.getSize());
+            raceConfig.finishLine = sizeOf(finishLineTexture.getSize());
+            raceConfig.player     = sizeOf(playerImage.getSize());
+            raceConfig.bottle     = sizeOf(bottleImage.getSize());
+            raceConfig.coin       = sizeOf(coinImage.getSize());
+            for (int i = 0; i < RaceConfig::TREE_KINDS; ++i)
+                raceConfig.trees[i] = sizeOf(treeImages[i].getSize());
+            for (int i = 0; i < RaceConfig::OBSTACLE_KINDS; ++i)
+                raceConfig.obstacles[i] = sizeOf(eplayerImages[i].getSize());
+            sim = RaceSimulation(raceConfig);
+
+            // — Crash masks at the sizes the sprites are drawn —
+            collisionMasks.player = CollisionMask::fromRgba(playerImage.getPixelsPtr(), playerImage.getSize().x,
+                                                            playerImage.getSize().y, raceConfig.playerScale);
+            for (int i = 0; i < RaceConfig::OBSTACLE_KINDS; ++i)
+                collisionMasks.obstacles[i] = CollisionMask::fromRgba(eplayerImages[i].getPixelsPtr(), eplayerImages[i].getSize().x,
+                                                                      eplayerImages[i].getSize().y, raceConfig.obstacleScale);
+
+            // The pixels now live in the atlas.
+            playerImage = bottleImage = coinImage = sf::Image();
+            treeImages.clear();
+            eplayerImages.clear();
+
+            assetsLoaded = true;
+        }
+        else if (loader.failed())
+            return -1;
+
+    
+        // Clear the window at the beginning of each frame.
+        window.clear();
+    
+        // Get a pulsating alpha value for menus.
+        float time = clock.getElapsedTime().asSeconds();
+        int alpha = static_cast<int>(127.5f * (std::sin(time * 2 * 3.1415f) + 1));
+    
+        // --- STATE HANDLING ---
+    
+        // LOADING STATE:
+        if (gameState == LOADING) {
+            if (assetsLoaded) {
+                // Reset game state variables (or start the recorded race).
+                if (replayPending) {
+                    replay.start(sim);
+                    replaySize = sf::Vector2u(static_cast<unsigned>(sim.cfg.viewWidth), static_cast<unsigned>(sim.cfg.viewHeight));
+                    window.setSize(replaySize);
+                    replayPending = false;
+                    replaying = true;
+                } else if (benchScenario) {
+                    RaceConfig benchConfig = sim.cfg;
+                    benchScenario->tune(benchConfig);
+                    sim = RaceSimulation(benchConfig);
+                    sim.reset(nextSeed++);
+                    benchRaceFrames = 0;
+                    benchClock.restart();
+                } else {
+                    sim.reset(nextSeed++);
+                    if (recordRaces)
+                        recording.begin(sim);
+                }
+                pendingInput = RaceInput();
+                sim.masks = &collisionMasks;
+                sim.telemetry = telemetry.get();
+                simThread.setAutopilot(opts.autopilot && !benchScenario && !replaying ? &autopilot : nullptr);
+                history.clear();
+                simThread.setHistory(benchScenario ? nullptr : &history);
+                simThread.start(benchScenario != nullptr, recordRaces && !replaying ? &recording : nullptr,
+                                replaying ? &replay : nullptr);
+                gameState = GAME;
+                continue;
+            }
+            // Display a simple loading screen with the real progress.
+            float winW = static_cast<float>(window.getSize().x);
+            float winH = static_cast<float>(window.getSize().y);
+            float progress = loader.progress();
+            int percent = static_cast<int>(progress * 100.f);
+            if (percent != loadingPercent) {
+                loadingText.setString("Chargement en cours... " + std::to_string(percent) + "%");
+                loadingPercent = percent;
+            }
+            batch.clear();
+            batch.addRect(LAYER_HUD, 0.f, 0.f, winW, winH, sf::Color::Black);
+            batch.addRect(LAYER_HUD, winW * 0.25f, winH/2.f + 50.f, winW * 0.5f * progress, 8.f, sf::Color::Yellow);
+            loadingText.draw(batch, winW/2.f - loadingText.getLocalBounds().width/2.f, winH/2.f,
+                             sf::Color(255, 255, 0, alpha));
+            batch.draw(window);
+            window.display();
+            continue; // Skip the rest of the frame.
+        }
+        
+        // MENU STATE:
+        if (gameState == MENU) {
+            // Nobody is playing: let the autopilot race a demo.
+            if (assetsLoaded && !benchScenario && focused && menuIdleClock.getElapsedTime().asSeconds() > ATTRACT_AFTER) {
+                sim.reset(demoSeed++);
+                sim.masks = &collisionMasks;
+                sim.telemetry = nullptr;  // not a session's gameplay
+                simThread.setAutopilot(&autopilot);
+                simThread.setHistory(nullptr);
+                simThread.start(false, nullptr, nullptr);
+                attract = true;
+                gameState = GAME;
+                continue;
+            }
+            // Render the 3 menu items (each with its shadow); only the
+            // selected one pulses, the rest is cached with the background.
+            float centerX = window.getSize().x / 2.f;
+            float startY = window.getSize().y / 2.f - 80.f;
+            auto drawItem = [&](int i, const sf::Color &shadow, const sf::Color &color) {
+                sf::FloatRect bounds = menu[i].getLocalBounds();
+                float x = centerX - (bounds.width / 2.f + bounds.left);
+                float y = startY + i * 60.f - bounds.top;
+                menu[i].draw(batch, x + 2, y + 2, shadow);
+                menu[i].draw(batch, x, y, color);
+            };
+            if (sf::RenderTarget *target = screenCache.compose(window, MENU * 8 + selected)) {
+                drawBackground(*target);
+                batch.clear();
+                for (int i = 0; i < 3; ++i)
+                    if (i != selected)
+                        drawItem(i, sf::Color::Black, sf::Color::White);
+                batch.draw(*target);
+            }
+            screenCache.present(window);
+            batch.clear();
+            drawItem(selected, sf::Color(0, 0, 0, alpha), sf::Color(255, 255, 0, alpha));
+            batch.draw(window);
+            window.display();
+            continue; // Skip further game processing.
+        }
+        
+        // APROPOS STATE (About Screen):
+        else if (gameState == APROPOS) {
+            // Draw background (cached; only the text moves).
+            if (sf::RenderTarget *target = screenCache.compose(window, APROPOS * 8))
+                drawBackground(*target);
+            screenCache.present(window);
+
+            // Scroll the about text upward.
+            // (Assumes aproposTexts is a vector of vector of strings; currentTextIndex indexes the current page.)
+            float scrollY = window.getSize().y + 40.f - aproposScrollClock.getElapsedTime().asSeconds() * 60.f;
+            batch.clear();
+            float cx = window.getSize().x / 2.f;
+            const std::vector<UiText> &lines = aproposLines[currentTextIndex];
+            for (size_t i = 0; i < lines.size(); ++i) {
+                float px = cx - lines[i].getLocalBounds().width / 2.f;
+                float py = scrollY + i * 40.f;
+                if (py > -50 && py < window.getSize().y - 80) { // Only draw if visible.
+                    lines[i].draw(batch, px + 2, py + 2, sf::Color::Black);
+                    lines[i].draw(batch, px, py, sf::Color::White);
+                }
+            }
+            // If text scrolled past threshold, show next page.
+            if (scrollY + aproposTexts[currentTextIndex].size() * 40.f < -100.f) {
+                currentTextIndex = (currentTextIndex + 1) % aproposTexts.size();
+                aproposScrollClock.restart();
+            }
+            // Draw a fixed "RETOUR AU MENU" button.
+            sf::FloatRect rb = menu[3].getLocalBounds();
+            float rx = window.getSize().x / 2.f - (rb.width / 2.f + rb.left);
+            float ry = window.getSize().y - 60.f;
+            menu[3].draw(batch, rx + 2, ry + 2, sf::Color(0, 0, 0, alpha));
+            menu[3].draw(batch, rx, ry, sf::Color(255, 255, 0, alpha));
+            batch.draw(window);
+            window.display();
+            continue;
+        }
+        
+        // FINISH STATE:
+    // ===== FINISH STATE =====
+    // ===== FINISH STATE =====
+    else if (gameState == FINISH) {
+        // Real‑time finish‑screen loop with pulsating "RETOUR AU MENU".
+        // The texts are laid out once here; the loop only redraws them.
+        finishScore.setString("Votre score est " + std::to_string(sim.score));
+        screenCache.invalidate();
+        sf::FloatRect returnBtnBounds;
+
+        while (window.isOpen() && gameState == FINISH) {
+            {
+                PROFILE_SCOPE(ZONE_PACE);
+                pacer.wait();
+            }
+            logFrame();
+            profiler.endFrame();
+            profiler.beginFrame();
+
+            // Center the texts (the window may have been resized)
+            float cx = window.getSize().x/2.f;
+            sf::FloatRect tb = finishTitle.getLocalBounds();
+            sf::FloatRect sb = finishScore.getLocalBounds();
+            sf::FloatRect bb = returnBtn.getLocalBounds();
+            sf::Vector2f btnPos(cx - (bb.width/2.f + bb.left), window.getSize().y*0.6f + 250.f);
+            returnBtnBounds = sf::FloatRect(btnPos.x + bb.left, btnPos.y + bb.top, bb.width, bb.height);
+
+            sf::Event ev;
+            while (window.pollEvent(ev)) {
+                if (ev.type == sf::Event::Closed) {
+                    window.close();
+                    break;
+                }
+                if (ev.type == sf::Event::LostFocus || ev.type == sf::Event::GainedFocus)
+                    focused = ev.type == sf::Event::GainedFocus;
+                if (ev.type == sf::Event::Resized)
+                    window.setView(sf::View(sf::FloatRect(0, 0, ev.size.width, ev.size.height)));
+                if (ev.type == sf::Event::KeyPressed && ev.key.code == sf::Keyboard::Enter) {
+                    voices.play(clickBuf, PRIORITY_NORMAL);
+                    gameState = MENU; selected = 0;
+                }
+                if (ev.type == sf::Event::MouseButtonPressed &&
+                    returnBtnBounds.contains(
+                        static_cast<float>(ev.mouseButton.x),
+                        static_cast<float>(ev.mouseButton.y)
+                    ))
+                {
+                    voices.play(clickBuf, PRIORITY_NORMAL);
+                    gameState = MENU; selected = 0;
+                }
+            }
+            if (!window.isOpen()) break;
+
+            // —— Pulsating alpha exactly like your menu buttons ——
+            float pulseTime = clock.getElapsedTime().asSeconds();
+            sf::Uint8 alpha = static_cast<sf::Uint8>(
+                127.5f * (std::sin(pulseTime * 2 * 3.14159265f) + 1)
+            );
+
+            // —— Title and score come from the cache, only the button is drawn every frame ——
+            applyFrameLimit();
+            window.clear();
+            if (sf::RenderTarget *target = screenCache.compose(window, FINISH * 8)) {
+                batch.clear();
+                finishTitle.draw(batch, cx - (tb.width/2.f + tb.left), target->getSize().y*0.2f, sf::Color::Yellow);
+                finishScore.draw(batch, cx - (sb.width/2.f + sb.left), target->getSize().y*0.4f + 80.f, sf::Color::White);
+                batch.draw(*target);
+            }
+            screenCache.present(window);
+            batch.clear();
+
+            // Return button with shadow: yellow text + black shadow, both fading in/out
+            returnBtn.draw(batch, btnPos.x + 2.f, btnPos.y + 2.f, sf::Color(0, 0, 0, alpha));
+            returnBtn.draw(batch, btnPos.x, btnPos.y, sf::Color(255, 255, 0, alpha));
+
+            batch.draw(window);
+            window.display();
+        }
+
+        // If window was closed inside that loop, bail out of main loop too
+        if (!window.isOpen()) break;
+        continue;
+    }
+    // ===== GAME / HIT STATE =====
+    else {
+        // Process input for boosting/braking
+        RaceInput input = pendingInput;
+        pendingInput = RaceInput();
+        input.boost =
+               sf::Keyboard::isKeyPressed(sf::Keyboard::W) ||
+               sf::Keyboard::isKeyPressed(sf::Keyboard::Up) ||
+               sf::Keyboard::isKeyPressed(sf::Keyboard::Space);
+        input.brake =
+               sf::Keyboard::isKeyPressed(sf::Keyboard::S) ||
+               sf::Keyboard::isKeyPressed(sf::Keyboard::Down);
+
+        // A bench scripts the input, resizes the window on schedule and
+        // advances the race by a fixed 1/60 s per frame, so every build
+        // simulates exactly the same race.
+        if (benchScenario) {
+            input = benchScenario->input(benchFrame);
+            if (benchScenario->resizeEvery > 0 && benchFrame > 0 && benchFrame % benchScenario->resizeEvery == 0)
+                window.setSize(window.getSize().x == 800 ? sf::Vector2u(1024, 768) : sf::Vector2u(800, 600));
+        }
+
+        // The kill-cam plays while the race is paused; the race picks up
+        // again once it is over.
+        if (killCam.active() && !killCam.advance(killCamClock.restart().asSeconds())) {
+            killCam.stop();
+            simThread.resume();
+        }
+
+        // Hand the input to the simulation thread; it steps the race on its
+        // own clock (lane changes go to its next step).
+        SimCommand cmd;
+        cmd.type = benchScenario ? SimCommand::FRAME : SimCommand::INPUT;
+        cmd.input = input;
+        cmd.dt = 1.f / 60.f;
+        if (benchScenario) {
+            // Every bench frame is simulated before it is drawn, so a frame's
+            // time covers both and the stats see the state it produced.
+            while (!simThread.send(cmd))
+                std::this_thread::yield();
+            ++benchRaceFrames;
+            for (const RaceSnapshot *s = &simThread.snapshot();
+                 s->lockstepFrames < benchRaceFrames && (s->state == GAME || s->state == HIT);
+                 s = &simThread.snapshot())
+                std::this_thread::yield();
+        } else if (!focusPaused && !killCam.active() && !simThread.send(cmd)) {
+            pendingInput.laneChange = input.laneChange;  // queue full: try again next frame
+        }
+
+        // Draw the newest published step, interpolated towards now (or the
+        // kill-cam's step).
+        const RaceSnapshot &live = simThread.snapshot();
+        const RaceSnapshot &snap = killCam.active() ? killCam.frame() : live;
+        float alpha = killCam.active() ? killCam.alpha() : snap.alphaAt(std::chrono::steady_clock::now());
+
+        // Play whatever the race asked for (the demo plays silently).
+        unsigned events = killCam.active() ? EVENT_NONE : simThread.takeEvents();
+        if (attract)
+            events = EVENT_NONE;
+        if (events & EVENT_TIRED)  voices.play(tiredBuf, PRIORITY_NORMAL);
+        if (events & EVENT_FINISH) voices.play(finishBuf, PRIORITY_HIGH);
+        if (events & EVENT_CRASH)  voices.play(crashBuf, PRIORITY_HIGH);
+        if (events & EVENT_DRINK)  voices.play(drinkBuf, PRIORITY_LOW);
+        if (events & EVENT_COIN)   voices.play(coinBuf, PRIORITY_LOW);
+        gameState = live.replayEnded ? MENU : live.state;
+
+        // A replay resizes the window the way it was recorded.
+        sf::Vector2u recordedSize(static_cast<unsigned>(live.cfg.viewWidth), static_cast<unsigned>(live.cfg.viewHeight));
+        if (replaying && recordedSize != replaySize) {
+            replaySize = recordedSize;
+            window.setSize(replaySize);
+        }
+
+        if (gameState != GAME && gameState != HIT) {
+            // The race is over and the thread has stopped stepping it.
+            simThread.pause();
+            if (attract) {
+                // The demo is over: back to the menu.
+                attract = false;
+                gameState = MENU;
+            } else if (benchScenario) {
+                // Keep racing until the bench has all its frames.
+                benchOverflowed += sim.track.overflowed();
+                sim.reset(nextSeed++);
+                benchRaceFrames = 0;
+                simThread.start(true, nullptr, nullptr);
+                gameState = GAME;
+            } else {
+                if (recordRaces && !replaying && !recording.save(opts.recordPath))
+                    std::cerr << "Failed to save recording " << opts.recordPath << "\n";
+                replaying = false;
+            }
+        }
+
+        // A crash the race goes on after: show the 2.5 s before it at half speed.
+        if ((events & EVENT_CRASH) && gameState == HIT && !attract && !benchScenario) {
+            simThread.pause();  // the history is only read while the race is paused
+            int crashStep = history.lastStepWith(EVENT_CRASH);
+            if (crashStep >= 0 &&
+                killCam.start(history, crashStep - RaceHistory::stepsOf(2.5f), history.newestStep(), 0.5f))
+                killCamClock.restart();
+            else
+                simThread.resume();
+        }
+
+        // — Collect the frame into the sprite batch, layer by layer —
+        ProfileScope trackScope(ZONE_DRAW_TRACK);
+        batch.clear();
+        float rw = static_cast<float>(roadTexture.getSize().x);
+        float roadLeft = snap.roadLeft;
+        float winW = static_cast<float>(window.getSize().x);
+        float winH = static_cast<float>(window.getSize().y);
+
+        // The race is in world space: nothing on the ground moves, a camera
+        // scrolls over it instead (the HUD keeps the window's view). Only
+        // what the camera sees goes into the batch.
+        float viewTop = snap.viewTopAt(alpha);
+        float viewBottom = viewTop + winH;
+        sf::View camera(sf::FloatRect(0.f, viewTop, winW, winH));
+        for (BatchLayer layer : { LAYER_GRASS, LAYER_ROAD, LAYER_SHADOWS, LAYER_ENTITIES })
+            batch.setView(layer, camera);
+        auto inView = [&](float y, float h) { return y < viewBottom && y + h > viewTop; };
+
+        // Grass margins, one repeated-texture strip from the texture row above the view
+        float grassH = static_cast<float>(grassTexture.getSize().y);
+        float grassTop = grassH > 0.f ? std::floor(viewTop / grassH) * grassH : viewTop;
+        sf::FloatRect grassRect(0.f, 0.f, std::floor(roadLeft), winH + grassH);
+        batch.add(LAYER_GRASS, &grassTexture, grassRect, 0.f, grassTop, 1.f, 1.f);
+        batch.add(LAYER_GRASS, &grassTexture, grassRect, roadLeft + rw, grassTop, 1.f, 1.f);
+
+        // Road tiles, from the tile row above the view so the bottom is always covered
+        float roadTop = std::floor(viewTop / tileH) * tileH;
+        for (int i = 0; i < roadTileCount; ++i)
+            batch.add(LAYER_ROAD, roadTexture, roadLeft, roadTop + i * tileH);
+
+        // Finish line
+        if (snap.finishLineSpawned)
+            batch.add(LAYER_ROAD, finishLineTexture, snap.finishX, snap.finishY, snap.finishScale);
+
+        trackScope.stop();
+
+        // Trees
+        ProfileScope entitiesScope(ZONE_DRAW_ENTITIES);
+        for (int i = 0; i < snap.trees.size(); ++i)
+            if (inView(snap.trees.y[i], snap.cfg.trees[snap.trees.kind[i]].h))
+                batch.add(LAYER_ENTITIES, entityAtlas.region(treeRegions[snap.trees.kind[i]]),
+                          snap.trees.x[i], snap.trees.y[i]);
+
+        // Obstacles with their shadow
+        const sf::Color shadowColor(0, 0, 0, 150);
+        for (int i = 0; i < snap.obstacles.size(); ++i) {
+            float ox = snap.obstacles.x[i], oy = snap.obstacles.yAt(i, alpha);
+            if (!inView(oy, snap.cfg.obstacles[snap.obstacles.kind[i]].h * snap.cfg.obstacleScale + 5.f))
+                continue;
+            const AtlasRegion &region = entityAtlas.region(eplayerRegions[snap.obstacles.kind[i]]);
+            batch.add(LAYER_SHADOWS, region, ox + 5.f, oy + 5.f, snap.cfg.obstacleScale, shadowColor);
+            batch.add(LAYER_ENTITIES, region, ox, oy, snap.cfg.obstacleScale);
+        }
+
+        // Hit blink effect
+        sf::Color playerColor = sf::Color::White;
+        if (snap.state == HIT)
+            playerColor.a = static_cast<sf::Uint8>(255 * std::abs(std::sin(snap.hitTime * 10.f)));
+
+        // Player and shadow (it rides along with the camera)
+        float px = snap.playerXAt(alpha), py = viewTop + snap.playerY;
+        batch.add(LAYER_SHADOWS, entityAtlas.region(playerRegion), px + 5.f, py + 5.f, 0.20f, shadowColor);
+        batch.add(LAYER_ENTITIES, entityAtlas.region(playerRegion), px, py, snap.cfg.playerScale, playerColor);
+
+        // Collectibles
+        float bottleH = snap.cfg.bottle.h * snap.cfg.bottleScale, coinH = snap.cfg.coin.h * snap.cfg.coinScale;
+        for (int i = 0; i < snap.bottles.size(); ++i)
+            if (inView(snap.bottles.y[i], bottleH))
+                batch.add(LAYER_ENTITIES, entityAtlas.region(bottleRegion),
+                          snap.bottles.x[i], snap.bottles.y[i], snap.cfg.bottleScale);
+        for (int i = 0; i < snap.coins.size(); ++i)
+            if (inView(snap.coins.y[i], coinH))
+                batch.add(LAYER_ENTITIES, entityAtlas.region(coinRegion),
+                          snap.coins.x[i], snap.coins.y[i], snap.cfg.coinScale);
+
+        entitiesScope.stop();
+
+        // Stamina bar
+        ProfileScope hudScope(ZONE_DRAW_HUD);
+        const float BAR_W = 20.f, BAR_H = 150.f;
+        float barX = winW - BAR_W - 20.f;
+        float barY = (winH - BAR_H) / 2.f;
+        float fillH = (snap.stamina / snap.cfg.maxStamina) * BAR_H;
+        batch.addRect(LAYER_HUD, barX, barY, BAR_W, BAR_H, sf::Color(50, 50, 50, 200));
+        batch.addRect(LAYER_HUD, barX, barY + (BAR_H - fillH), BAR_W, fillH, sf::Color(100, 100, 255, 200));
+
+        // Race progress bar
+        const float PB_W = 300.f, PB_H = 15.f;
+        float progress = std::min(1.f, snap.distanceTraveled / snap.cfg.raceDistance());
+        float pbX = (winW - PB_W) / 2.f;
+        float pbY = winH - PB_H - 10.f;
+        batch.addRect(LAYER_HUD, pbX, pbY, PB_W, PB_H, sf::Color(50, 50, 50, 200));
+        batch.addRect(LAYER_HUD, pbX, pbY, PB_W * progress, PB_H, sf::Color(100, 255, 100, 220));
+
+        // HUD: Score and Lives (the string only changes when they do)
+        if (snap.score != hudScore || snap.lives != hudLives) {
+            hud.setString("Score: " + std::to_string(snap.score) + "  Lives: " + std::to_string(snap.lives));
+            hudScore = snap.score;
+            hudLives = snap.lives;
+        }
+        hud.draw(batch, 20.f, 20.f);
+
+        // ← STAMINA label
+        staminaLabel.draw(batch,
+            barX - staminaLabel.getLocalBounds().width - 10.f,   // to the left of the bar
+            barY - staminaLabel.getCharacterSize());             // just above it
+
+        // ← VOTRE POSITION label
+        positionLabel.draw(batch,
+            pbX,                                                  // align left edge to bar
+            pbY - positionLabel.getCharacterSize() - 5.f);        // just above bar
+
+        // Attract mode banner
+        if (attract) {
+            sf::Uint8 pulse = static_cast<sf::Uint8>(127.5f * (std::sin(time * 2 * 3.1415f) + 1));
+            sf::FloatRect db = demoText.getLocalBounds();
+            float dx = winW / 2.f - (db.width / 2.f + db.left);
+            demoText.draw(batch, dx + 2.f, winH * 0.3f + 2.f, sf::Color(0, 0, 0, pulse));
+            demoText.draw(batch, dx, winH * 0.3f, sf::Color(255, 255, 0, pulse));
+        }
+
+        // Kill-cam banner
+        if (killCam.active()) {
+            sf::FloatRect rb = replayText.getLocalBounds();
+            float rx = winW / 2.f - (rb.width / 2.f + rb.left);
+            replayText.draw(batch, rx + 2.f, winH * 0.3f + 2.f, sf::Color::Black);
+            replayText.draw(batch, rx, winH * 0.3f, sf::Color::Red);
+        }
+
+        // Profiler overlay (last frame's numbers)
+        if (showProfiler) {
+            if (profilerTextClock.getElapsedTime().asSeconds() > 0.25f) {
+                profilerText.setString(profilerReport(profiler, pacer));
+                profilerTextClock.restart();
+            }
+            sf::FloatRect pb = profilerText.getLocalBounds();
+            batch.addRect(LAYER_HUD, 5.f, 55.f, pb.width + pb.left + 10.f, pb.height + pb.top + 10.f, sf::Color(0, 0, 0, 170));
+            profilerText.draw(batch, 10.f, 60.f, sf::Color(180, 255, 180));
+        }
+        hudScope.stop();
+
+        {
+            PROFILE_SCOPE(ZONE_SUBMIT);
+            batch.draw(window);
+        }
+        profiler.setCounter(COUNTER_DRAW_CALLS, batch.drawCalls());
+        profiler.setCounter(COUNTER_ENTITIES, snap.entityCount());
+        {
+            PROFILE_SCOPE(ZONE_DISPLAY);
+            window.display();
+        }
+
+        // Bench bookkeeping; the first frame is warm-up and not measured.
+        if (benchScenario) {
+            float frameMs = benchClock.restart().asSeconds() * 1000.f;
+            if (benchFrame > 0) {
+                benchFrameMs.push_back(frameMs);
+                benchEntities += snap.entityCount();
+            }
+            if (++benchFrame > opts.benchFrames) {
+                simThread.pause();  // done; the course can be read
+                benchOverflowed += sim.track.overflowed();
+                BenchStats st = BenchStats::of(benchFrameMs);
+                double secs = st.mean * benchFrameMs.size() / 1000.0;
+                std::cout << "bench=" << benchScenario->name << " frames=" << benchFrameMs.size()
+                          << " mean_ms=" << st.mean << " p50_ms=" << st.p50 << " p99_ms=" << st.p99
+                          << " worst_ms=" << st.worst
+                          << " entities_per_sec=" << (secs > 0.0 ? benchEntities / secs : 0.0)
+                          << " draw_calls=" << batch.drawCalls()
+                          << " track_overflow=" << benchOverflowed << "\n";
+                window.close();
+            }
+        }
+
+    } // End GAME/HIT state
+
+    // Loop back to start of main while
+} // End while(window.isOpen())
+
+// Get the race back from the simulation thread before saving anything.
+simThread.pause();
+
+if (opts.profile && pacer.histogram().count() > 0) {
+    const FrameHistogram &pacing = pacer.histogram();
+    std::cout << "frame pacing: frames=" << pacing.count() << " p50_err_ms=" << pacing.percentile(0.5f)
+              << " p99_err_ms=" << pacing.percentile(0.99f) << " worst_err_ms=" << pacing.worst() << "\n"
+              << pacing.table();
+}
+
+if (profiler.tracing()) {
+    profiler.endFrame();
+    if (!profiler.writeTrace(opts.tracePath))
+        std::cerr << "Failed to write trace " << opts.tracePath << "\n";
+}
+
+// Keep the race that was interrupted by closing the window.
+if (recordRaces && !replaying && !attract && (gameState == GAME || gameState == HIT) && !recording.save(opts.recordPath))
+    std::cerr << "Failed to save recording " << opts.recordPath << "\n";
+
+return 0;
+} // End main
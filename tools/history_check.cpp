@@ -0,0 +1,140 @@
+//
+// RaceHistory self-check: races a long endless course through a deliberately
+// small history ring, so the byte ring wraps many times over records of
+// every size (keyframes, pool changes, plain deltas, resizes and a rewind),
+// and checks after every few steps that each step still in the history
+// decodes to exactly the state that was recorded.
+//
+// Usage: history_check [steps] [ring bytes]
+//
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "../BatchRunner.hpp"
+#include "../RaceHistory.hpp"
+
+// Texture sizes close to the game's, so spawning and collisions behave the same.
+static RaceConfig checkConfig()
+{
+    RaceConfig cfg;
+    cfg.road = { 400.f, 256.f };
+    cfg.grass = { 64.f, 64.f };
+    cfg.finishLine = { 400.f, 40.f };
+    cfg.player = { 200.f, 300.f };
+    cfg.bottle = { 100.f, 200.f };
+    cfg.coin = { 150.f, 150.f };
+    for (SpriteSize &t : cfg.trees)
+        t = { 80.f, 120.f };
+    for (SpriteSize &o : cfg.obstacles)
+        o = { 200.f, 300.f };
+    cfg.startLives = 1 << 30;
+    cfg.numTiles = 1 << 20;
+    return cfg;
+}
+
+// FNV-1a over raw bytes.
+static void mix(std::uint64_t &h, const void *data, std::size_t n)
+{
+    const std::uint8_t *p = static_cast<const std::uint8_t *>(data);
+    for (std::size_t i = 0; i < n; ++i)
+        h = (h ^ p[i]) * 1099511628211ull;
+}
+
+template <int N>
+static void mixPool(std::uint64_t &h, const PoolSnapshot<N> &pool)
+{
+    mix(h, &pool.count, sizeof pool.count);
+    mix(h, pool.x, sizeof(float) * pool.count);
+    mix(h, pool.y, sizeof(float) * pool.count);
+    mix(h, pool.prevY, sizeof(float) * pool.count);
+    mix(h, pool.kind, pool.count);
+}
+
+// Everything the history promises to bring back for drawing.
+static std::uint64_t fingerprint(const RaceSnapshot &s)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    const float floats[] = { s.stamina, s.hitTime, s.distanceTraveled, s.trackPos, s.playerX,
+                             s.prevPlayerX, s.playerY, s.roadLeft, s.finishX, s.finishY,
+                             s.finishScale, s.lastScroll, s.cfg.viewWidth, s.cfg.viewHeight };
+    const int ints[] = { s.state, s.finishLineSpawned, s.lives, s.score };
+    mix(h, floats, sizeof floats);
+    mix(h, ints, sizeof ints);
+    mixPool(h, s.trees);
+    mixPool(h, s.obstacles);
+    mixPool(h, s.bottles);
+    mixPool(h, s.coins);
+    return h;
+}
+
+// Decodes every step still in the history, forward and from its keyframe;
+// returns how many came out different from what was recorded.
+static int checkAll(const RaceHistory &history, const std::vector<std::uint64_t> &recorded,
+                    RaceSnapshot &forward, RaceSnapshot &fromKey)
+{
+    int bad = 0, prev = -1;
+    for (int s = history.oldestStep(); s <= history.newestStep(); ++s) {
+        if (!history.decode(s, forward, prev) || fingerprint(forward) != recorded[s])
+            ++bad;
+        prev = s;
+        if (s % 13 == 0 && (!history.decode(s, fromKey) || fingerprint(fromKey) != recorded[s]))
+            ++bad;
+    }
+    return bad;
+}
+
+int main(int argc, char **argv)
+{
+    int steps = argc > 1 ? std::atoi(argv[1]) : 12000;
+    std::size_t ring = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 24 * 1024;
+
+    std::unique_ptr<RaceSimulation> sim(new RaceSimulation);
+    sim->cfg = checkConfig();
+    sim->cfg.treeRate *= 8.f;  // busy pools: records of very different sizes
+    sim->cfg.coinRate *= 8.f;
+    sim->reset(1);
+    std::unique_ptr<RaceHistory> history(new RaceHistory(ring));
+    std::unique_ptr<RaceSnapshot> live(new RaceSnapshot), forward(new RaceSnapshot),
+        fromKey(new RaceSnapshot);
+
+    std::vector<std::uint64_t> recorded;  // fingerprint of every step, by history step
+    std::size_t minWindow = static_cast<std::size_t>(-1);
+    int bad = 0, checks = 0;
+    for (int i = 0; i < steps; ++i) {
+        if (i % 997 == 996)
+            sim->resize(i % 2 ? 900.f : 800.f, i % 2 ? 700.f : 600.f);
+        sim->step(sweepDriver(*sim), RaceSimulation::STEP_DT);
+        history->record(*sim);
+        live->capture(*sim);
+        recorded.resize(history->newestStep() + 1);
+        recorded[history->newestStep()] = fingerprint(*live);
+
+        if (i == steps / 2) {  // drop the newest second and carry on from there
+            int back = history->rewind(*sim, RaceHistory::stepsOf(1.f));
+            if (back < 0) {
+                std::printf("rewind failed\n");
+                return 1;
+            }
+            live->capture(*sim);
+            if (fingerprint(*live) != recorded[back])
+                ++bad;
+        }
+        if (i % 89 == 0) {
+            bad += checkAll(*history, recorded, *forward, *fromKey);
+            ++checks;
+            std::size_t window = history->newestStep() - history->oldestStep() + 1;
+            if (i >= RaceHistory::STEPS && window < minWindow)
+                minWindow = window;
+        }
+    }
+    bad += checkAll(*history, recorded, *forward, *fromKey);
+
+    std::printf("%d steps through a %zu byte ring: %d checks, at least %zu steps kept, %d bad\n",
+                steps, ring, checks + 1, minWindow, bad);
+    return bad == 0 ? 0 : 1;
+}
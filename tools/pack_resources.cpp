@@ -0,0 +1,132 @@
+//
+// Build-time resource packer: walks resources/ and writes resources.pak
+// (see ResourceArchive.hpp). Images are decoded to RGBA8 and sound effects
+// to 16-bit PCM here, once, so the game never inflates a PNG at startup.
+// Streamed music (.ogg) and fonts are stored unchanged.
+//
+// Usage: pack_resources [resources dir] [output file]
+//
+
+#include <SFML/Audio.hpp>
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../ResourceArchive.hpp"
+
+namespace fs = std::filesystem;
+
+struct PackedFile {
+    std::string name;
+    ArchiveEntry entry{};
+    std::vector<char> payload;
+};
+
+static std::string lowerExtension(const fs::path &p)
+{
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext;
+}
+
+static bool pack(const fs::path &path, PackedFile &out)
+{
+    std::string ext = lowerExtension(path);
+    if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tga") {
+        sf::Image img;
+        if (!img.loadFromFile(path.string()))
+            return false;
+        sf::Vector2u s = img.getSize();
+        const char *px = reinterpret_cast<const char *>(img.getPixelsPtr());
+        out.entry.kind = ArchiveEntry::IMAGE;
+        out.entry.a = s.x;
+        out.entry.b = s.y;
+        out.payload.assign(px, px + std::size_t(s.x) * s.y * 4);
+        return true;
+    }
+    if (ext == ".wav" || ext == ".flac") {
+        sf::InputSoundFile file;
+        if (!file.openFromFile(path.string()))
+            return false;
+        std::vector<sf::Int16> samples(static_cast<std::size_t>(file.getSampleCount()));
+        if (file.read(samples.data(), samples.size()) != samples.size())
+            return false;
+        const char *bytes = reinterpret_cast<const char *>(samples.data());
+        out.entry.kind = ArchiveEntry::SOUND;
+        out.entry.a = file.getChannelCount();
+        out.entry.b = file.getSampleRate();
+        out.payload.assign(bytes, bytes + samples.size() * sizeof(sf::Int16));
+        return true;
+    }
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    out.entry.kind = ArchiveEntry::RAW;
+    out.payload.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    fs::path root = argc > 1 ? argv[1] : "resources";
+    std::string outPath = argc > 2 ? argv[2] : "resources.pak";
+
+    std::vector<PackedFile> files;
+    std::vector<fs::path> paths;
+    for (const auto &it : fs::recursive_directory_iterator(root))
+        if (it.is_regular_file())
+            paths.push_back(it.path());
+    std::sort(paths.begin(), paths.end());
+
+    std::string names;
+    for (const fs::path &p : paths) {
+        PackedFile f;
+        f.name = fs::relative(p, root).generic_string();
+        if (!pack(p, f)) {
+            std::cerr << "Failed to pack " << p.string() << "\n";
+            return 1;
+        }
+        f.entry.nameOffset = static_cast<std::uint32_t>(names.size());
+        f.entry.nameSize = static_cast<std::uint32_t>(f.name.size());
+        names += f.name;
+        files.push_back(std::move(f));
+    }
+
+    // Lay the payloads out after the table of contents, 16-byte aligned.
+    ArchiveHeader header{ { 'B', 'K', 'R', 'A' }, ARCHIVE_VERSION,
+                          static_cast<std::uint32_t>(files.size()), static_cast<std::uint32_t>(names.size()) };
+    auto align = [](std::uint64_t v) { return (v + 15) & ~std::uint64_t(15); };
+    std::uint64_t offset = align(sizeof header + files.size() * sizeof(ArchiveEntry) + names.size());
+    for (PackedFile &f : files) {
+        f.entry.offset = offset;
+        f.entry.size = f.payload.size();
+        offset = align(offset + f.payload.size());
+    }
+
+    std::ofstream out(outPath, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to open " << outPath << "\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof header);
+    for (const PackedFile &f : files)
+        out.write(reinterpret_cast<const char *>(&f.entry), sizeof f.entry);
+    out.write(names.data(), names.size());
+    for (const PackedFile &f : files) {
+        while (static_cast<std::uint64_t>(out.tellp()) < f.entry.offset)
+            out.put('\0');
+        out.write(f.payload.data(), f.payload.size());
+    }
+    if (!out) {
+        std::cerr << "Failed to write " << outPath << "\n";
+        return 1;
+    }
+    std::cout << "Packed " << files.size() << " files into " << outPath << " (" << offset << " bytes)\n";
+    return 0;
+}
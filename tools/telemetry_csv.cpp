@@ -0,0 +1,82 @@
+//
+// Offline telemetry decoder: turns the binary logs written with --telemetry
+// (see Telemetry.hpp) into CSV on stdout, one row per record, files in the
+// order given.
+//
+// Usage: telemetry_csv log.0 [log.1 ...] > telemetry.csv
+//
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "../Telemetry.hpp"
+
+// Same order as GameState and TrackItemType (RaceSimulation.hpp, TrackStream.hpp).
+static const char *stateName(int s)
+{
+    static const char *names[] = { "MENU", "APROPOS", "LOADING", "GAME", "HIT", "FINISH" };
+    return s >= 0 && s < 6 ? names[s] : "?";
+}
+
+static const char *itemName(int t)
+{
+    static const char *names[] = { "tree", "obstacle", "bottle", "coin" };
+    return t >= 0 && t < 4 ? names[t] : "?";
+}
+
+// The arg column spelled out where it is an enum.
+static std::string detail(const TelemetryRecord &r)
+{
+    switch (r.type) {
+    case TELEMETRY_STATE:  return std::string(stateName(r.value)) + "->" + stateName(r.arg);
+    case TELEMETRY_SPAWN:
+    case TELEMETRY_PICKUP: return itemName(r.arg);
+    default:               return "";
+    }
+}
+
+static bool decode(const char *path)
+{
+    std::FILE *f = std::fopen(path, "rb");
+    if (!f) {
+        std::cerr << "Can't open " << path << "\n";
+        return false;
+    }
+    char magic[4];
+    std::uint32_t version = 0, recordSize = 0, fileNumber = 0;
+    std::uint64_t startMs = 0;
+    bool ok = std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, "BKTL", 4) == 0 &&
+              std::fread(&version, sizeof version, 1, f) == 1 &&
+              std::fread(&recordSize, sizeof recordSize, 1, f) == 1 &&
+              std::fread(&fileNumber, sizeof fileNumber, 1, f) == 1 &&
+              std::fread(&startMs, sizeof startMs, 1, f) == 1;
+    if (!ok || version != Telemetry::VERSION || recordSize != sizeof(TelemetryRecord)) {
+        std::cerr << path << " is not a telemetry log of this version\n";
+        std::fclose(f);
+        return false;
+    }
+    TelemetryRecord r;
+    while (std::fread(&r, sizeof r, 1, f) == 1) {
+        std::printf("%u,%llu,%.6f,%s,%u,%s,%d,%g,%g\n", fileNumber,
+                    static_cast<unsigned long long>(startMs + r.time / 1000000), r.time / 1e9,
+                    telemetryEventName(r.type), r.arg, detail(r).c_str(), r.value, r.x, r.y);
+    }
+    std::fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: telemetry_csv log.0 [log.1 ...] > telemetry.csv\n";
+        return 1;
+    }
+    std::printf("file,unix_ms,time_s,event,arg,detail,value,x,y\n");
+    bool ok = true;
+    for (int i = 1; i < argc; ++i)
+        ok = decode(argv[i]) && ok;
+    return ok ? 0 : 1;
+}